@@ -1,6 +1,39 @@
 #include <iostream>
 #include <random>
 #include <memory>
+#include <span>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <limits>
+#include <new>
+#include <cmath>
+#include <string_view>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <bit>
+#include <numbers>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HAS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions that opt in with a target attribute,
+// which lets one binary carry both kernels and pick one at runtime. MSVC always allows the intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_ATTRIBUTE(isa) __attribute__((target(isa)))
+#else
+#define TARGET_ATTRIBUTE(isa)
+#endif
 
 int random_int(int lowerBound, int upperBound) {
     
@@ -20,37 +53,624 @@ int random_int(int lowerBound, int upperBound) {
     return distr(eng);
 };
 
+// --- Price array kernels ---
+
+// Every price array starts on a 64 byte boundary (a cache line, and a multiple of the 32 bytes of an AVX2 register),
+// so the AVX2 kernels can use aligned loads and stores and a 4 wide load never straddles two cache lines.
+constexpr size_t priceAlignment = 64;
+
+// Frees arrays allocated with the aligned operator new, for std::unique_ptr.
+struct AlignedDelete {
+    void operator()(double* ptr) const {
+        ::operator delete[](ptr, std::align_val_t{priceAlignment});
+    }
+};
+
+using AlignedPrices = std::unique_ptr<double[], AlignedDelete>;
+
+AlignedPrices allocateAlignedPrices(size_t n) {
+    return AlignedPrices(static_cast<double*>(::operator new[](n * sizeof(double), std::align_val_t{priceAlignment})));
+}
+
+// Bulk operations over a price array. Each has a plain loop version and an AVX2 version, picked once at runtime.
+// values must be 32 byte aligned, returns can be anywhere.
+struct PriceKernels {
+    const char* name;
+    double (*sum)(const double* values, size_t n);
+    double (*squaredDeviations)(const double* values, size_t n, double mean); // sum of (x - mean)^2
+    void (*minMax)(const double* values, size_t n, double& min, double& max);
+    void (*scale)(double* values, size_t n, double factor);                 // values *= factor
+    void (*compound)(double* values, const double* returns, size_t n);      // values[i] *= 1 + returns[i]
+};
+
+// Several independent accumulators let the CPU overlap the additions instead of waiting on one long dependency chain.
+double sumScalar(const double* values, size_t n) {
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc[0] += values[i];
+        acc[1] += values[i + 1];
+        acc[2] += values[i + 2];
+        acc[3] += values[i + 3];
+    }
+    for (; i < n; ++i) {
+        acc[0] += values[i];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+double squaredDeviationsScalar(const double* values, size_t n, double mean) {
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            double deviation = values[i + lane] - mean;
+            acc[lane] += deviation * deviation;
+        }
+    }
+    for (; i < n; ++i) {
+        acc[0] += (values[i] - mean) * (values[i] - mean);
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+void minMaxScalar(const double* values, size_t n, double& min, double& max) {
+    double mins[4], maxs[4];
+    std::fill(mins, mins + 4, std::numeric_limits<double>::infinity());
+    std::fill(maxs, maxs + 4, -std::numeric_limits<double>::infinity());
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            mins[lane] = values[i + lane] < mins[lane] ? values[i + lane] : mins[lane];
+            maxs[lane] = values[i + lane] > maxs[lane] ? values[i + lane] : maxs[lane];
+        }
+    }
+    for (; i < n; ++i) {
+        mins[0] = std::min(mins[0], values[i]);
+        maxs[0] = std::max(maxs[0], values[i]);
+    }
+    min = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+    max = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+}
+
+void scaleScalar(double* values, size_t n, double factor) {
+    for (size_t i = 0; i < n; ++i) {
+        values[i] *= factor;
+    }
+}
+
+void compoundScalar(double* values, const double* returns, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        values[i] *= 1.0 + returns[i];
+    }
+}
+
+#if defined(HAS_X86_SIMD)
+// Adds the 4 lanes of a register together.
+TARGET_ATTRIBUTE("avx2")
+double horizontalSum(__m256d v) {
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+TARGET_ATTRIBUTE("avx2")
+double sumAvx2(const double* values, size_t n) {
+    // four registers of 4 lanes = 16 independent accumulators, enough to keep both add units busy
+    // while each add waits the ~4 cycles for its previous result
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_load_pd(values + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_load_pd(values + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_load_pd(values + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_load_pd(values + i + 12));
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm256_add_pd(acc0, _mm256_load_pd(values + i));
+    }
+    double sum = horizontalSum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    for (; i < n; ++i) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+TARGET_ATTRIBUTE("avx2")
+double squaredDeviationsAvx2(const double* values, size_t n, double mean) {
+    const __m256d vmean = _mm256_set1_pd(mean);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d d0 = _mm256_sub_pd(_mm256_load_pd(values + i), vmean);
+        __m256d d1 = _mm256_sub_pd(_mm256_load_pd(values + i + 4), vmean);
+        __m256d d2 = _mm256_sub_pd(_mm256_load_pd(values + i + 8), vmean);
+        __m256d d3 = _mm256_sub_pd(_mm256_load_pd(values + i + 12), vmean);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+        acc2 = _mm256_add_pd(acc2, _mm256_mul_pd(d2, d2));
+        acc3 = _mm256_add_pd(acc3, _mm256_mul_pd(d3, d3));
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_sub_pd(_mm256_load_pd(values + i), vmean);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d, d));
+    }
+    double sum = horizontalSum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    for (; i < n; ++i) {
+        sum += (values[i] - mean) * (values[i] - mean);
+    }
+    return sum;
+}
+
+TARGET_ATTRIBUTE("avx2")
+void minMaxAvx2(const double* values, size_t n, double& min, double& max) {
+    // two registers each for min and max, so consecutive comparisons do not wait on each other
+    __m256d vmin = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    __m256d vmax = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    __m256d vmin1 = vmin;
+    __m256d vmax1 = vmax;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d v0 = _mm256_load_pd(values + i);
+        __m256d v1 = _mm256_load_pd(values + i + 4);
+        vmin = _mm256_min_pd(vmin, v0);
+        vmax = _mm256_max_pd(vmax, v0);
+        vmin1 = _mm256_min_pd(vmin1, v1);
+        vmax1 = _mm256_max_pd(vmax1, v1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_load_pd(values + i);
+        vmin = _mm256_min_pd(vmin, v);
+        vmax = _mm256_max_pd(vmax, v);
+    }
+    vmin = _mm256_min_pd(vmin, vmin1);
+    vmax = _mm256_max_pd(vmax, vmax1);
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, vmin);
+    min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm256_store_pd(lanes, vmax);
+    max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < n; ++i) {
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+}
+
+TARGET_ATTRIBUTE("avx2")
+void scaleAvx2(double* values, size_t n, double factor) {
+    const __m256d vfactor = _mm256_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_store_pd(values + i, _mm256_mul_pd(_mm256_load_pd(values + i), vfactor));
+    }
+    for (; i < n; ++i) {
+        values[i] *= factor;
+    }
+}
+
+TARGET_ATTRIBUTE("avx2")
+void compoundAvx2(double* values, const double* returns, size_t n) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d growth = _mm256_add_pd(one, _mm256_loadu_pd(returns + i));
+        _mm256_store_pd(values + i, _mm256_mul_pd(_mm256_load_pd(values + i), growth));
+    }
+    for (; i < n; ++i) {
+        values[i] *= 1.0 + returns[i];
+    }
+}
+
+bool cpuSupportsAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    // AVX2 also needs the OS to save the wide registers on context switch (OSXSAVE + XCR0 bits)
+    bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+// Fused multiply-add (a * b + c in one instruction, one rounding) came with AVX2 on every Intel and AMD core
+// but is a separate feature bit.
+bool cpuSupportsFma() {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 12)) != 0;
+#else
+    return false;
+#endif
+}
+#endif
+
+// Every kernel set this CPU can run, slowest first.
+std::vector<PriceKernels> availablePriceKernels() {
+    std::vector<PriceKernels> kernels = {{"scalar", sumScalar, squaredDeviationsScalar, minMaxScalar, scaleScalar, compoundScalar}};
+#if defined(HAS_X86_SIMD)
+    if (cpuSupportsAvx2()) {
+        kernels.push_back({"avx2", sumAvx2, squaredDeviationsAvx2, minMaxAvx2, scaleAvx2, compoundAvx2});
+    }
+#endif
+    return kernels;
+}
+
+// Feature detection runs once, on first use.
+const PriceKernels& bestPriceKernels() {
+    static const PriceKernels best = availablePriceKernels().back();
+    return best;
+}
+
+// --- Counter-based random numbers ---
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", the generator behind cuRAND and
+// Random123). Instead of a state that has to be stepped through in order like mt19937, it is a function:
+// it scrambles a 128-bit counter with a 64-bit key in 10 rounds of multiply and xor and gives 4 random 32-bit numbers.
+// Number i of a stream is therefore computable directly, without generating 0..i-1, so any number of threads
+// can fill any part of an array and the result depends only on the seed.
+constexpr uint32_t philoxMultiplier0 = 0xD2511F53;
+constexpr uint32_t philoxMultiplier1 = 0xCD9E8D57;
+constexpr uint32_t philoxKeyStep0 = 0x9E3779B9; // golden ratio
+constexpr uint32_t philoxKeyStep1 = 0xBB67AE85; // sqrt(3) - 1
+
+// The 4 random numbers of counter (index, stream) under key seed.
+constexpr std::array<uint32_t, 4> philoxBlock(uint64_t index, uint64_t stream, uint64_t seed) {
+    std::array<uint32_t, 4> c = {static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32),
+                                 static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+    uint32_t key0 = static_cast<uint32_t>(seed);
+    uint32_t key1 = static_cast<uint32_t>(seed >> 32);
+    for (int round = 0; round < 10; round++) {
+        uint64_t product0 = static_cast<uint64_t>(philoxMultiplier0) * c[0];
+        uint64_t product1 = static_cast<uint64_t>(philoxMultiplier1) * c[2];
+        c = {static_cast<uint32_t>(product1 >> 32) ^ c[1] ^ key0, static_cast<uint32_t>(product1),
+             static_cast<uint32_t>(product0 >> 32) ^ c[3] ^ key1, static_cast<uint32_t>(product0)};
+        key0 += philoxKeyStep0;
+        key1 += philoxKeyStep1;
+    }
+    return c;
+}
+
+// Known answers from the Random123 test vectors.
+static_assert(philoxBlock(0, 0, 0) == std::array<uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+static_assert(philoxBlock(~0ULL, ~0ULL, ~0ULL) == std::array<uint32_t, 4>{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+
+// Writes blocks firstIndex..firstIndex+count-1 of stream to out, 4 numbers per block, in counter order.
+// One block alone is a chain of 10 dependent multiplies; the kernels work on 8 blocks at once so the chains overlap.
+using PhiloxKernel = void (*)(uint64_t firstIndex, size_t count, uint64_t stream, uint64_t seed, uint32_t* out);
+
+// 8 blocks side by side in plain arrays: the CPU interleaves the independent multiplies of the 8 chains.
+void philoxBlocksScalar(uint64_t firstIndex, size_t count, uint64_t stream, uint64_t seed, uint32_t* out) {
+    size_t b = 0;
+    for (; b + 8 <= count; b += 8) {
+        uint32_t c0[8], c1[8], c2[8], c3[8];
+        for (int lane = 0; lane < 8; lane++) {
+            uint64_t index = firstIndex + b + lane;
+            c0[lane] = static_cast<uint32_t>(index);
+            c1[lane] = static_cast<uint32_t>(index >> 32);
+            c2[lane] = static_cast<uint32_t>(stream);
+            c3[lane] = static_cast<uint32_t>(stream >> 32);
+        }
+        uint32_t key0 = static_cast<uint32_t>(seed);
+        uint32_t key1 = static_cast<uint32_t>(seed >> 32);
+        for (int round = 0; round < 10; round++) {
+            for (int lane = 0; lane < 8; lane++) {
+                uint64_t product0 = static_cast<uint64_t>(philoxMultiplier0) * c0[lane];
+                uint64_t product1 = static_cast<uint64_t>(philoxMultiplier1) * c2[lane];
+                c0[lane] = static_cast<uint32_t>(product1 >> 32) ^ c1[lane] ^ key0;
+                c1[lane] = static_cast<uint32_t>(product1);
+                c2[lane] = static_cast<uint32_t>(product0 >> 32) ^ c3[lane] ^ key1;
+                c3[lane] = static_cast<uint32_t>(product0);
+            }
+            key0 += philoxKeyStep0;
+            key1 += philoxKeyStep1;
+        }
+        for (int lane = 0; lane < 8; lane++) {
+            uint32_t* block = out + 4 * (b + lane);
+            block[0] = c0[lane];
+            block[1] = c1[lane];
+            block[2] = c2[lane];
+            block[3] = c3[lane];
+        }
+    }
+    for (; b < count; b++) {
+        std::array<uint32_t, 4> block = philoxBlock(firstIndex + b, stream, seed);
+        std::copy(block.begin(), block.end(), out + 4 * b);
+    }
+}
+
+#if defined(HAS_X86_SIMD)
+// 8 x 32-bit lanes times a 32-bit constant, as the high and low halves of the 64-bit products.
+// mul_epu32 only multiplies the even lanes, so the odd ones are shifted down and multiplied separately.
+TARGET_ATTRIBUTE("avx2")
+void multiplyHighLow(__m256i x, __m256i multiplier, __m256i& high, __m256i& low) {
+    __m256i even = _mm256_mul_epu32(x, multiplier);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), multiplier);
+    high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    low = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+// The same 8 blocks, one per 32-bit lane of a register.
+TARGET_ATTRIBUTE("avx2")
+void philoxBlocksAvx2(uint64_t firstIndex, size_t count, uint64_t stream, uint64_t seed, uint32_t* out) {
+    const __m256i multiplier0 = _mm256_set1_epi64x(philoxMultiplier0);
+    const __m256i multiplier1 = _mm256_set1_epi64x(philoxMultiplier1);
+    size_t b = 0;
+    for (; b + 8 <= count; b += 8) {
+        alignas(32) uint32_t low[8], high[8];
+        for (int lane = 0; lane < 8; lane++) {
+            uint64_t index = firstIndex + b + lane;
+            low[lane] = static_cast<uint32_t>(index);
+            high[lane] = static_cast<uint32_t>(index >> 32);
+        }
+        __m256i c0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(low));
+        __m256i c1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(high));
+        __m256i c2 = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(stream)));
+        __m256i c3 = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(stream >> 32)));
+        uint32_t key0 = static_cast<uint32_t>(seed);
+        uint32_t key1 = static_cast<uint32_t>(seed >> 32);
+        for (int round = 0; round < 10; round++) {
+            __m256i high0, low0, high1, low1;
+            multiplyHighLow(c0, multiplier0, high0, low0);
+            multiplyHighLow(c2, multiplier1, high1, low1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(high1, c1), _mm256_set1_epi32(static_cast<int>(key0)));
+            c1 = low1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(high0, c3), _mm256_set1_epi32(static_cast<int>(key1)));
+            c3 = low0;
+            key0 += philoxKeyStep0;
+            key1 += philoxKeyStep1;
+        }
+        // transpose: registers hold word 0, 1, 2, 3 of every block, the output wants block after block
+        __m256i t0 = _mm256_unpacklo_epi32(c0, c1); // blocks 0,1 | 4,5, words 0 and 1
+        __m256i t1 = _mm256_unpackhi_epi32(c0, c1); // blocks 2,3 | 6,7
+        __m256i t2 = _mm256_unpacklo_epi32(c2, c3); // words 2 and 3
+        __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+        __m256i blocks04 = _mm256_unpacklo_epi64(t0, t2);
+        __m256i blocks15 = _mm256_unpackhi_epi64(t0, t2);
+        __m256i blocks26 = _mm256_unpacklo_epi64(t1, t3);
+        __m256i blocks37 = _mm256_unpackhi_epi64(t1, t3);
+        __m256i* target = reinterpret_cast<__m256i*>(out + 4 * b);
+        _mm256_storeu_si256(target, _mm256_permute2x128_si256(blocks04, blocks15, 0x20));
+        _mm256_storeu_si256(target + 1, _mm256_permute2x128_si256(blocks26, blocks37, 0x20));
+        _mm256_storeu_si256(target + 2, _mm256_permute2x128_si256(blocks04, blocks15, 0x31));
+        _mm256_storeu_si256(target + 3, _mm256_permute2x128_si256(blocks26, blocks37, 0x31));
+    }
+    if (b < count) {
+        philoxBlocksScalar(firstIndex + b, count - b, stream, seed, out + 4 * b);
+    }
+}
+#endif
+
+struct PhiloxKernelInfo {
+    const char* name;
+    PhiloxKernel kernel;
+};
+
+// Every kernel this CPU can run, slowest first. They all give the same numbers.
+std::vector<PhiloxKernelInfo> availablePhiloxKernels() {
+    std::vector<PhiloxKernelInfo> kernels = {{"scalar", philoxBlocksScalar}};
+#if defined(HAS_X86_SIMD)
+    if (cpuSupportsAvx2()) kernels.push_back({"avx2", philoxBlocksAvx2});
+#endif
+    return kernels;
+}
+
+PhiloxKernel bestPhiloxKernel() {
+    static const PhiloxKernel best = availablePhiloxKernels().back().kernel;
+    return best;
+}
+
+// One stream of Philox numbers: a seed (the key) and a stream number (upper half of the counter,
+// so different streams never overlap). Cheap to copy, it is just the two numbers.
+class PhiloxStream {
+    private:
+        uint64_t seed_;
+        uint64_t stream_;
+
+    public:
+        constexpr PhiloxStream(uint64_t seed, uint64_t stream) : seed_(seed), stream_(stream) {}
+
+        // Writes numbers first..first+out.size()-1 of the stream into out, each turned into a double by map(uint32_t).
+        template <typename Map>
+        void fill(std::span<double> out, uint64_t first, Map map, PhiloxKernel kernel = bestPhiloxKernel()) const {
+            constexpr size_t chunkBlocks = 64; // 1 KB of raw numbers, stays in L1 between generating and mapping
+            alignas(32) uint32_t raw[4 * chunkBlocks];
+            uint64_t block = first / 4;
+            size_t skip = first % 4; // a block that starts before first: only its tail belongs to us
+            size_t i = 0;
+            while (i < out.size()) {
+                size_t wanted = out.size() - i + skip;
+                size_t blocks = std::min(chunkBlocks, (wanted + 3) / 4);
+                kernel(block, blocks, this->stream_, this->seed_, raw);
+                size_t available = std::min(4 * blocks, wanted);
+                double* target = out.data() + i - skip;
+                for (size_t k = skip; k < available; k++) {
+                    target[k] = map(raw[k]);
+                }
+                i += available - skip;
+                block += blocks;
+                skip = 0;
+            }
+        }
+
+        // Same as fill, split into threadCount contiguous slices that run at the same time.
+        // Element i is always number first + i of the stream, so the output is the same for any threadCount.
+        template <typename Map>
+        void parallelFill(std::span<double> out, uint64_t first, unsigned threadCount, Map map, PhiloxKernel kernel = bestPhiloxKernel()) const {
+            // tiny arrays are not worth starting threads for
+            threadCount = static_cast<unsigned>(std::min<size_t>(std::max(threadCount, 1u), out.size() / 4096 + 1));
+            if (threadCount == 1) {
+                this->fill(out, first, map, kernel);
+                return;
+            }
+            std::vector<std::thread> threads;
+            for (unsigned t = 0; t < threadCount; t++) {
+                size_t begin = out.size() * t / threadCount;
+                size_t end = out.size() * (t + 1) / threadCount;
+                threads.emplace_back([this, out, first, begin, end, map, kernel] {
+                    this->fill(out.subspan(begin, end - begin), first + begin, map, kernel);
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        }
+
+        // Integers lowerBound..upperBound (both included) from number first on, stored as doubles like the portfolio prices.
+        // Multiply-shift (Lemire) instead of modulo: no division, bias below (upperBound - lowerBound + 1) / 2^32.
+        void fillUniformInt(std::span<double> out, int lowerBound, int upperBound, unsigned threadCount = 1, uint64_t first = 0) const {
+            if (lowerBound > upperBound) {
+                throw std::invalid_argument("lowerBound must be less than or equal to upperBound");
+            }
+            uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(upperBound) - lowerBound) + 1;
+            this->parallelFill(out, first, threadCount, [lowerBound, range](uint32_t r) {
+                return static_cast<double>(lowerBound + static_cast<int64_t>((r * range) >> 32));
+            });
+        }
+
+        // Doubles in [lowerBound, upperBound) from number first on, 32 random bits each.
+        void fillUniform(std::span<double> out, double lowerBound, double upperBound, unsigned threadCount = 1, uint64_t first = 0) const {
+            double step = (upperBound - lowerBound) / 4294967296.0; // 2^32
+            this->parallelFill(out, first, threadCount, [lowerBound, step](uint32_t r) { return lowerBound + r * step; });
+        }
+};
+
 class Portfolio {
+    public:
+        // Portfolios this small keep their prices inside the object instead of on the heap:
+        // creating, copying or destroying one never allocates.
+        static constexpr int smallCapacity = 8;
+
+        // How many times a Portfolio was deep-copied or moved on this thread, so a benchmark can show which one containers use.
+        // Per thread because simulatePortfolios moves portfolios into place from several threads at once: a shared
+        // counter would be a data race, and an atomic one would bounce its cache line between the cores on every move.
+        // The benchmarks and the demo copy and move on the main thread, so its counts are the ones they report.
+        static inline thread_local long long copies = 0;
+        static inline thread_local long long moves = 0;
+
+        // Portfolio(n) draws from stream 0, 1, 2, ... of this seed, so every new one gets different prices
+        // and a run of the program is reproducible.
+        static constexpr uint64_t defaultSeed = 42;
+        static inline std::atomic<uint64_t> nextStream{0};
+
     private:
-        std::unique_ptr<double[]> prices_; // smart pointer to manage dynamic array. heap
+        // prices_ points either at small_ (size_ <= smallCapacity) or at heap_ (bigger portfolios).
+        // A moved-from Portfolio is empty and points at its own small_ again.
+        // Both are aligned for the AVX2 kernels.
+        double* prices_;
         int size_;
+        AlignedPrices heap_; // smart pointer to manage dynamic array. only used when small_ is too small
+        alignas(32) double small_[smallCapacity];
+
+        // Points prices_ at storage for n prices, allocating only when the small buffer is not enough.
+        // Keeps the current heap block if it is exactly the right size, so assigning equal sized portfolios never allocates.
+        void allocate(int n) {
+            if (n <= smallCapacity) {
+                this->heap_.reset();
+                this->prices_ = this->small_;
+            } else if (!this->heap_ || this->size_ != n) {
+                this->heap_ = allocateAlignedPrices(n); // no zeroing, every price is written next
+                this->prices_ = this->heap_.get();
+            }
+            this->size_ = n;
+        }
+
+        // Takes other's prices and leaves other empty. For small portfolios the prices themselves have to be copied
+        // (they live inside the object), big ones just hand over the heap pointer.
+        void stealFrom(Portfolio& other) noexcept {
+            this->size_ = other.size_;
+            if (other.heap_) {
+                this->heap_ = std::move(other.heap_);
+                this->prices_ = this->heap_.get();
+            } else {
+                this->heap_.reset();
+                this->prices_ = this->small_;
+                std::copy(other.small_, other.small_ + other.size_, this->small_);
+            }
+            other.prices_ = other.small_;
+            other.size_ = 0;
+        }
+
+        // Average, variance, min and max have no value for an empty portfolio (they would be NaN or +-infinity).
+        void requireNotEmpty() const {
+            if (this->size_ == 0) {
+                throw std::out_of_range("Portfolio is empty");
+            }
+        }
 
     public:
+        // Empty portfolio, the same state a moved-from one is left in. Lets containers of portfolios be resized.
+        Portfolio() : prices_(small_), size_(0) {}
+
         // Constructor - same name as the class (no return type, __init__ in Python)
-        // Using member initializer list to initialize unique_ptr and size
-        // automatically initializes prices to a unique_ptr managing an array of n doubles, or nullptr if n <= 0. Initializer list is more efficient.
-        // size is initialized to n.
-        explicit Portfolio(const int& n) : prices_(n > 0 ? std::make_unique<double[]>(n) : nullptr), size_(n) {
+        // Fills n random prices between 100 and 500. Delegates to the constructor below with the next default stream.
+        explicit Portfolio(const int& n) : Portfolio(n, PhiloxStream(defaultSeed, nextStream++)) {}
+
+        // n random prices between 100 and 500 from rng, generated by threadCount threads.
+        // The same rng always gives the same prices, whatever the thread count. Size is validated before any storage is picked.
+        Portfolio(int n, const PhiloxStream& rng, unsigned threadCount = 1) : prices_(small_), size_(0) {
 
             if (n <= 0) {
                 throw std::invalid_argument("Portfolio size must be positive");
             }
 
-            for (int i = 0; i < this->size_; i++) {
-                this->prices_[i] = random_int(100, 500);
+            this->allocate(n);
+            rng.fillUniformInt(this->prices(), 100, 500, threadCount);
+        }
+
+        // Portfolio with the given prices, copied in.
+        explicit Portfolio(std::span<const double> prices) : prices_(small_), size_(0) {
+            if (prices.empty()) {
+                throw std::invalid_argument("Portfolio size must be positive");
             }
-        } 
+            this->allocate(static_cast<int>(prices.size()));
+            std::copy(prices.begin(), prices.end(), this->prices_);
+        }
 
         // Copy constructor - same name as the class (no return type), performs deep copy, argument is a reference to another object of the same class
-        Portfolio(const Portfolio& other) {
-            this->size_ = other.size_;
-            this->prices_ = std::make_unique<double[]>(this->size_);
+        Portfolio(const Portfolio& other) : prices_(small_), size_(0) {
+            this->allocate(other.size_);
+            std::copy(other.prices_, other.prices_ + other.size_, this->prices_);
+            copies++;
+        }
 
-            for (int i = 0; i < this->size_; i++) {
-                this->prices_[i] = other.prices_[i];
+        // Move constructor - takes over other's heap block instead of copying it. noexcept matters:
+        // std::vector only moves its elements when it grows if the move constructor cannot throw, otherwise it copies them.
+        // other is left empty, like a default constructed Portfolio: getSum() is 0, and getAveragePrice(), getVariance(),
+        // getMinPrice() and getMaxPrice() throw std::out_of_range until it is assigned new prices.
+        Portfolio(Portfolio&& other) noexcept : prices_(small_), size_(0) {
+            this->stealFrom(other);
+            moves++;
+        }
+
+        // Copy assignment - deep copy, reusing the storage already there when it fits
+        Portfolio& operator=(const Portfolio& other) {
+            if (this != &other) {
+                this->allocate(other.size_);
+                std::copy(other.prices_, other.prices_ + other.size_, this->prices_);
+                copies++;
             }
+            return *this;
+        }
 
-            std::cout << "Portfolio copied" << std::endl;
+        // Move assignment - drops our own prices and takes other's
+        Portfolio& operator=(Portfolio&& other) noexcept {
+            if (this != &other) {
+                this->stealFrom(other);
+                moves++;
+            }
+            return *this;
         }
 
         // Destructor - same name as the class with ~ prefix (no return type, __del__ in Python)
@@ -69,14 +689,78 @@ class Portfolio {
             return this->size_;
         }
 
-        double getAveragePrice() const {
-            double sum = 0.0;
+        // True when the prices are stored inside the object (no heap allocation).
+        bool isSmall() const {
+            return this->prices_ == this->small_;
+        }
 
-            for (int i = 0; i < this->size_; i++) {
-                sum += this->prices_[i];
+        // Views over the prices: work with range-for, std algorithms and any function taking a span,
+        // without copying and without going through setPriceAt one element at a time.
+        std::span<double> prices() {
+            return std::span<double>(this->prices_, this->size_);
+        }
+
+        std::span<const double> prices() const {
+            return std::span<const double>(this->prices_, this->size_);
+        }
+
+        double* begin() { return this->prices_; }
+        double* end() { return this->prices_ + this->size_; }
+        const double* begin() const { return this->prices_; }
+        const double* end() const { return this->prices_ + this->size_; }
+
+        // The aggregates and bulk updates take a kernel set that defaults to the fastest one this CPU supports,
+        // passing another is only useful for benchmarks.
+
+        double getSum(const PriceKernels& kernels = bestPriceKernels()) const {
+            return kernels.sum(this->prices_, this->size_);
+        }
+
+        double getAveragePrice(const PriceKernels& kernels = bestPriceKernels()) const {
+            this->requireNotEmpty();
+            return this->getSum(kernels) / this->size_;
+        }
+
+        // Population variance, two passes (mean first, then squared deviations from it) to avoid
+        // the cancellation of the sum of squares minus squared sum shortcut.
+        double getVariance(const PriceKernels& kernels = bestPriceKernels()) const {
+            double mean = this->getAveragePrice(kernels);
+            return kernels.squaredDeviations(this->prices_, this->size_, mean) / this->size_;
+        }
+
+        double getMinPrice(const PriceKernels& kernels = bestPriceKernels()) const {
+            this->requireNotEmpty();
+            double min, max;
+            kernels.minMax(this->prices_, this->size_, min, max);
+            return min;
+        }
+
+        double getMaxPrice(const PriceKernels& kernels = bestPriceKernels()) const {
+            this->requireNotEmpty();
+            double min, max;
+            kernels.minMax(this->prices_, this->size_, min, max);
+            return max;
+        }
+
+        // Every price grows by the same return: prices *= 1 + r.
+        void applyReturn(double r, const PriceKernels& kernels = bestPriceKernels()) {
+            kernels.scale(this->prices_, this->size_, 1.0 + r);
+        }
+
+        // Each price grows by its own return: prices[i] *= 1 + returns[i].
+        void applyReturns(std::span<const double> returns, const PriceKernels& kernels = bestPriceKernels()) {
+            if (returns.size() != static_cast<size_t>(this->size_)) {
+                throw std::invalid_argument("Need one return per position");
             }
-            
-            return sum / this->size_;
+            kernels.compound(this->prices_, returns.data(), returns.size());
+        }
+
+        // Overwrites the prices from offset on with prices, one bounds check for the whole range.
+        void setPrices(std::span<const double> prices, int offset = 0) {
+            if (offset < 0 || offset > this->size_ || prices.size() > static_cast<size_t>(this->size_ - offset)) {
+                throw std::out_of_range("Prices do not fit");
+            }
+            std::copy(prices.begin(), prices.end(), this->prices_ + offset);
         }
 
         void setPriceAt(int index, double price) {
@@ -88,7 +772,684 @@ class Portfolio {
 
 };
 
-int main() {
+// count portfolios of size random prices between 100 and 500, built by threadCount threads.
+// Portfolio i gets numbers i * size .. (i + 1) * size - 1 of one Philox stream, so the result is the same for any
+// thread count. Each thread generates the prices of a contiguous range of portfolios in bulk and moves the portfolios
+// straight into their slots of the result, so nothing is copied or moved a second time.
+std::vector<Portfolio> simulatePortfolios(size_t count, int size, uint64_t seed, unsigned threadCount) {
+    if (size <= 0) {
+        throw std::invalid_argument("Portfolio size must be positive");
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(std::max(threadCount, 1u), std::max<size_t>(count, 1)));
+    std::vector<Portfolio> portfolios(count);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; t++) {
+        size_t begin = count * t / threadCount;
+        size_t end = count * (t + 1) / threadCount;
+        threads.emplace_back([&portfolios, begin, end, size, seed] {
+            constexpr size_t batch = 1024; // portfolios whose prices are generated in one go
+            std::vector<double> prices(batch * size);
+            for (size_t first = begin; first < end; first += batch) {
+                size_t n = std::min(batch, end - first);
+                PhiloxStream(seed, 0).fillUniformInt(std::span<double>(prices.data(), n * size), 100, 500, 1, first * size);
+                for (size_t i = 0; i < n; i++) {
+                    portfolios[first + i] = Portfolio(std::span<const double>(prices.data() + i * size, size));
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return portfolios;
+}
+
+// --- Monte Carlo risk ---
+
+// Lower triangular L with L * L^T = covariance (n x n, row major), by the Cholesky-Banachiewicz algorithm.
+// Multiplying independent standard normals by L gives normals with that covariance.
+// Throws when the matrix is not symmetric positive definite (some portfolio of the assets would have zero or negative variance).
+std::vector<double> choleskyFactor(std::span<const double> covariance, size_t n) {
+    if (covariance.size() != n * n) {
+        throw std::invalid_argument("Covariance must be an n x n matrix");
+    }
+    std::vector<double> factor(n * n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            double sum = covariance[i * n + j];
+            for (size_t k = 0; k < j; k++) {
+                sum -= factor[i * n + k] * factor[j * n + k];
+            }
+            if (i == j) {
+                if (!(sum > 0.0)) {
+                    throw std::invalid_argument("Covariance is not positive definite");
+                }
+                factor[i * n + i] = std::sqrt(sum);
+            } else {
+                factor[i * n + j] = sum / factor[j * n + j];
+            }
+        }
+    }
+    return factor;
+}
+
+// Paths are simulated in batches of this many, each batch with its own Philox stream. The batch is the unit of work
+// a thread takes, and its buffers (assets x riskBatch doubles) are laid out so every loop over paths is contiguous.
+constexpr size_t riskBatch = 64;
+
+// The three steps of simulating a batch, each with a plain loop version and an AVX2 + FMA version, picked at runtime.
+struct RiskKernels {
+    const char* name;
+    // Box-Muller: pair j of standard normals from the 128 random bits raw[4j..4j+3], written to out[2j] and out[2j+1].
+    void (*normals)(const uint32_t* raw, size_t pairs, double* out);
+    // x = factor * z for riskBatch paths: z and x are assets x riskBatch, factor is assets x assets lower triangular.
+    void (*correlate)(const double* factor, size_t assets, const double* z, double* x);
+    // values[b] += weight * exp(x[b]) for the riskBatch paths of one asset.
+    void (*addExp)(const double* x, double weight, double* values);
+};
+
+// 52 random bits as a double in [1, 2): the bits go into the mantissa of 1.0. Exact and branch free.
+inline double unitInterval(uint32_t low, uint32_t high) {
+    uint64_t bits = (static_cast<uint64_t>(high) << 32) | low;
+    return std::bit_cast<double>((bits >> 12) | 0x3FF0000000000000ULL);
+}
+
+void normalsScalar(const uint32_t* raw, size_t pairs, double* out) {
+    for (size_t j = 0; j < pairs; j++) {
+        double u1 = 2.0 - unitInterval(raw[4 * j], raw[4 * j + 1]);  // (0, 1], so the log is finite
+        double u2 = unitInterval(raw[4 * j + 2], raw[4 * j + 3]) - 1.0; // [0, 1)
+        double radius = std::sqrt(-2.0 * std::log(u1));
+        double angle = 2.0 * std::numbers::pi * u2;
+        out[2 * j] = radius * std::cos(angle);
+        out[2 * j + 1] = radius * std::sin(angle);
+    }
+}
+
+void correlateScalar(const double* factor, size_t assets, const double* z, double* x) {
+    for (size_t i = 0; i < assets; i++) {
+        double* row = x + i * riskBatch;
+        std::fill(row, row + riskBatch, 0.0);
+        for (size_t k = 0; k <= i; k++) {
+            double l = factor[i * assets + k];
+            const double* source = z + k * riskBatch;
+            for (size_t b = 0; b < riskBatch; b++) {
+                row[b] += l * source[b];
+            }
+        }
+    }
+}
+
+void addExpScalar(const double* x, double weight, double* values) {
+    for (size_t b = 0; b < riskBatch; b++) {
+        values[b] += weight * std::exp(x[b]);
+    }
+}
+
+#if defined(HAS_X86_SIMD)
+// std::exp, std::log, std::sin and std::cos work on one double at a time. These do 4, with polynomials
+// accurate to about 1e-15 relative over the ranges the simulation uses.
+
+// e^x for |x| <= 708: e^x = 2^k * e^r with k = round(x / ln 2) and |r| <= ln(2) / 2, e^r by its Taylor series.
+TARGET_ATTRIBUTE("avx2,fma")
+__m256d expAvx2(__m256d x) {
+    x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-708.0)), _mm256_set1_pd(708.0));
+    __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(std::numbers::log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    // ln 2 split in a high part with trailing zero bits and the rest, so k * high is exact
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(6.93147180369123816490e-01), x);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(1.90821492927058770002e-10), r);
+    __m256d p = _mm256_set1_pd(1.0 / 479001600.0); // 1/12!
+    const double inverseFactorials[] = {1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0, 1.0 / 40320.0, 1.0 / 5040.0,
+                                        1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0};
+    for (double c : inverseFactorials) {
+        p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(c));
+    }
+    // 2^k built directly in the exponent bits
+    __m256i k64 = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k));
+    __m256i scale = _mm256_slli_epi64(_mm256_add_epi64(k64, _mm256_set1_epi64x(1023)), 52);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(scale));
+}
+
+// ln u for normal positive u: u = m * 2^e with m in [sqrt(1/2), sqrt(2)], ln m = 2 atanh(f) with f = (m - 1) / (m + 1).
+TARGET_ATTRIBUTE("avx2,fma")
+__m256d logAvx2(__m256d u) {
+    __m256i bits = _mm256_castpd_si256(u);
+    // the biased exponent turned into a double with the 2^52 trick (AVX2 has no int64 to double conversion)
+    __m256i exponentBits = _mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x4330000000000000LL));
+    __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(exponentBits), _mm256_set1_pd(4503599627370496.0 + 1023.0));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+                                                    _mm256_set1_epi64x(0x3FF0000000000000LL)));
+    __m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(std::numbers::sqrt2), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+    e = _mm256_add_pd(e, _mm256_and_pd(big, _mm256_set1_pd(1.0)));
+    __m256d f = _mm256_div_pd(_mm256_sub_pd(m, _mm256_set1_pd(1.0)), _mm256_add_pd(m, _mm256_set1_pd(1.0)));
+    __m256d s = _mm256_mul_pd(f, f);
+    __m256d p = _mm256_set1_pd(1.0 / 19.0);
+    for (double c : {1.0 / 17.0, 1.0 / 15.0, 1.0 / 13.0, 1.0 / 11.0, 1.0 / 9.0, 1.0 / 7.0, 1.0 / 5.0, 1.0 / 3.0, 1.0}) {
+        p = _mm256_fmadd_pd(p, s, _mm256_set1_pd(c));
+    }
+    return _mm256_fmadd_pd(e, _mm256_set1_pd(std::numbers::ln2), _mm256_mul_pd(_mm256_add_pd(f, f), p));
+}
+
+// sin and cos of 2 pi u for u in [0, 1): u * 4 = q + y' with q the nearest quarter turn, so y = y' pi / 2 is in
+// [-pi/4, pi/4] where the Taylor series converge fast, then the quarter turn swaps and negates the results.
+TARGET_ATTRIBUTE("avx2,fma")
+void sinCosTurnsAvx2(__m256d u, __m256d& sine, __m256d& cosine) {
+    __m256d t = _mm256_mul_pd(u, _mm256_set1_pd(4.0));
+    __m256d q = _mm256_round_pd(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d y = _mm256_mul_pd(_mm256_sub_pd(t, q), _mm256_set1_pd(std::numbers::pi / 2.0));
+    __m256d y2 = _mm256_mul_pd(y, y);
+    __m256d ps = _mm256_set1_pd(-1.0 / 1307674368000.0); // -1/15!
+    for (double c : {1.0 / 6227020800.0, -1.0 / 39916800.0, 1.0 / 362880.0, -1.0 / 5040.0, 1.0 / 120.0, -1.0 / 6.0, 1.0}) {
+        ps = _mm256_fmadd_pd(ps, y2, _mm256_set1_pd(c));
+    }
+    ps = _mm256_mul_pd(ps, y);
+    __m256d pc = _mm256_set1_pd(1.0 / 20922789888000.0); // 1/16!
+    for (double c : {-1.0 / 87178291200.0, 1.0 / 479001600.0, -1.0 / 3628800.0, 1.0 / 40320.0, -1.0 / 720.0, 1.0 / 24.0, -0.5, 1.0}) {
+        pc = _mm256_fmadd_pd(pc, y2, _mm256_set1_pd(c));
+    }
+    // quarter turn 0: (sin y, cos y), 1: (cos y, -sin y), 2: (-sin y, -cos y), 3: (-cos y, sin y)
+    __m256i quarter = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(q));
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i two = _mm256_set1_epi64x(2);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    __m256d swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(quarter, one), one));
+    __m256d negateSine = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(quarter, two), two));
+    __m256d negateCosine = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(_mm256_add_epi64(quarter, one), two), two));
+    sine = _mm256_xor_pd(_mm256_blendv_pd(ps, pc, swap), _mm256_and_pd(negateSine, signBit));
+    cosine = _mm256_xor_pd(_mm256_blendv_pd(pc, ps, swap), _mm256_and_pd(negateCosine, signBit));
+}
+
+TARGET_ATTRIBUTE("avx2,fma")
+void normalsAvx2(const uint32_t* raw, size_t pairs, double* out) {
+    const __m256i oneBits = _mm256_set1_epi64x(0x3FF0000000000000LL);
+    size_t j = 0;
+    for (; j + 4 <= pairs; j += 4) {
+        // each 64-bit lane is one uniform: lanes alternate u1, u2 for pairs j, j+1 (first load) and j+2, j+3 (second)
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(raw + 4 * j));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(raw + 4 * j + 8));
+        // unpack gives the u1s (and the u2s) of pairs j, j+2, j+1, j+3
+        __m256i u1Bits = _mm256_unpacklo_epi64(first, second);
+        __m256i u2Bits = _mm256_unpackhi_epi64(first, second);
+        __m256d u1 = _mm256_sub_pd(_mm256_set1_pd(2.0), _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(u1Bits, 12), oneBits)));
+        __m256d u2 = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(u2Bits, 12), oneBits)), _mm256_set1_pd(1.0));
+        __m256d radius = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_set1_pd(-2.0), logAvx2(u1)));
+        __m256d sine, cosine;
+        sinCosTurnsAvx2(u2, sine, cosine);
+        __m256d z0 = _mm256_mul_pd(radius, cosine); // pairs j, j+2, j+1, j+3
+        __m256d z1 = _mm256_mul_pd(radius, sine);
+        // interleave back to z0, z1 of pair j, then pair j+1, ...
+        _mm256_storeu_pd(out + 2 * j, _mm256_unpacklo_pd(z0, z1));
+        _mm256_storeu_pd(out + 2 * j + 4, _mm256_unpackhi_pd(z0, z1));
+    }
+    normalsScalar(raw + 4 * j, pairs - j, out + 2 * j);
+}
+
+// Register tile of 4 assets x 8 paths: for every k, 2 loads of z and 4 broadcasts of factor feed 8 FMAs, and the
+// 8 accumulators are independent, enough to cover the FMA latency. Written out by hand because at -O2 GCC does not
+// fully unroll small loops over arrays of registers and the accumulators end up in memory (2.5x slower).
+// The factor is stored as a full square matrix with zeros above the diagonal, so a tile can run k up to its
+// last row without checking which of its rows already ended.
+TARGET_ATTRIBUTE("avx2,fma")
+void correlateAvx2(const double* factor, size_t assets, const double* z, double* x) {
+    size_t i = 0;
+    for (; i + 4 <= assets; i += 4) {
+        const double* row0 = factor + i * assets;
+        const double* row1 = row0 + assets;
+        const double* row2 = row1 + assets;
+        const double* row3 = row2 + assets;
+        for (size_t b = 0; b < riskBatch; b += 8) {
+            __m256d acc00 = _mm256_setzero_pd(), acc01 = _mm256_setzero_pd();
+            __m256d acc10 = _mm256_setzero_pd(), acc11 = _mm256_setzero_pd();
+            __m256d acc20 = _mm256_setzero_pd(), acc21 = _mm256_setzero_pd();
+            __m256d acc30 = _mm256_setzero_pd(), acc31 = _mm256_setzero_pd();
+            for (size_t k = 0; k <= i + 3; k++) {
+                __m256d z0 = _mm256_load_pd(z + k * riskBatch + b);
+                __m256d z1 = _mm256_load_pd(z + k * riskBatch + b + 4);
+                __m256d l0 = _mm256_broadcast_sd(row0 + k);
+                __m256d l1 = _mm256_broadcast_sd(row1 + k);
+                __m256d l2 = _mm256_broadcast_sd(row2 + k);
+                __m256d l3 = _mm256_broadcast_sd(row3 + k);
+                acc00 = _mm256_fmadd_pd(l0, z0, acc00);
+                acc01 = _mm256_fmadd_pd(l0, z1, acc01);
+                acc10 = _mm256_fmadd_pd(l1, z0, acc10);
+                acc11 = _mm256_fmadd_pd(l1, z1, acc11);
+                acc20 = _mm256_fmadd_pd(l2, z0, acc20);
+                acc21 = _mm256_fmadd_pd(l2, z1, acc21);
+                acc30 = _mm256_fmadd_pd(l3, z0, acc30);
+                acc31 = _mm256_fmadd_pd(l3, z1, acc31);
+            }
+            double* out = x + i * riskBatch + b;
+            _mm256_store_pd(out, acc00);
+            _mm256_store_pd(out + 4, acc01);
+            _mm256_store_pd(out + riskBatch, acc10);
+            _mm256_store_pd(out + riskBatch + 4, acc11);
+            _mm256_store_pd(out + 2 * riskBatch, acc20);
+            _mm256_store_pd(out + 2 * riskBatch + 4, acc21);
+            _mm256_store_pd(out + 3 * riskBatch, acc30);
+            _mm256_store_pd(out + 3 * riskBatch + 4, acc31);
+        }
+    }
+    for (; i < assets; i++) {
+        for (size_t b = 0; b < riskBatch; b += 4) {
+            __m256d acc = _mm256_setzero_pd();
+            for (size_t k = 0; k <= i; k++) {
+                acc = _mm256_fmadd_pd(_mm256_broadcast_sd(factor + i * assets + k), _mm256_load_pd(z + k * riskBatch + b), acc);
+            }
+            _mm256_store_pd(x + i * riskBatch + b, acc);
+        }
+    }
+}
+
+TARGET_ATTRIBUTE("avx2,fma")
+void addExpAvx2(const double* x, double weight, double* values) {
+    const __m256d w = _mm256_set1_pd(weight);
+    for (size_t b = 0; b < riskBatch; b += 4) {
+        _mm256_store_pd(values + b, _mm256_fmadd_pd(w, expAvx2(_mm256_load_pd(x + b)), _mm256_load_pd(values + b)));
+    }
+}
+#endif
+
+// Every kernel set this CPU can run, slowest first.
+std::vector<RiskKernels> availableRiskKernels() {
+    std::vector<RiskKernels> kernels = {{"scalar", normalsScalar, correlateScalar, addExpScalar}};
+#if defined(HAS_X86_SIMD)
+    if (cpuSupportsAvx2() && cpuSupportsFma()) {
+        kernels.push_back({"avx2", normalsAvx2, correlateAvx2, addExpAvx2});
+    }
+#endif
+    return kernels;
+}
+
+const RiskKernels& bestRiskKernels() {
+    static const RiskKernels best = availableRiskKernels().back();
+    return best;
+}
+
+struct RiskMeasure {
+    double confidence;        // e.g. 0.99
+    double valueAtRisk;       // loss that is exceeded with probability 1 - confidence
+    double expectedShortfall; // average loss in those worst cases (CVaR)
+};
+
+// Value at risk and expected shortfall of holding a Portfolio over one horizon, by Monte Carlo.
+// Asset i is the portfolio's price i, held quantities[i] times. Log returns over the horizon are jointly normal
+// with the given covariance and mean drift[i] - covariance[i][i] / 2 (geometric Brownian motion, so drift = 0 means
+// the expected price stays where it is). The end value of GBM is exact in one step, so each path is one draw of
+// correlated normals: z independent normals -> x = L z with L the Cholesky factor -> prices * exp(mean + x).
+class RiskEngine {
+    private:
+        size_t assets_;
+        double startValue_;
+        std::vector<double> factor_;  // Cholesky factor of the covariance
+        std::vector<double> weights_; // value held in asset i times e^mean_i, so the end value is sum weights_[i] e^x_i
+
+        // Philox streams the engine draws from: "RISK" in the upper 32 bits of the stream number, the batch in the lower 32.
+        // Portfolio prices and other inputs use small stream numbers of the same seeds (0, 1, 2, ... from nextStream),
+        // so without the tag batch 0 of seed defaultSeed would reuse the exact bits that produced the prices it values.
+        static constexpr uint64_t riskStreamTag = 0x5249534BULL << 32;
+
+        // Simulates batch number batch (paths batch * riskBatch ...) into losses[0..count).
+        void simulateBatch(size_t batch, size_t count, uint64_t seed, const RiskKernels& kernels,
+                           std::vector<uint32_t>& raw, double* z, double* x, double* values, double* losses) const {
+            size_t pairs = this->assets_ * riskBatch / 2;
+            bestPhiloxKernel()(0, pairs, riskStreamTag | batch, seed, raw.data()); // one Philox block of 128 bits per pair of normals
+            kernels.normals(raw.data(), pairs, z);
+            kernels.correlate(this->factor_.data(), this->assets_, z, x);
+            std::fill(values, values + riskBatch, 0.0);
+            for (size_t i = 0; i < this->assets_; i++) {
+                kernels.addExp(x + i * riskBatch, this->weights_[i], values);
+            }
+            for (size_t b = 0; b < count; b++) {
+                losses[b] = this->startValue_ - values[b];
+            }
+        }
+
+    public:
+        // quantities and drift may be empty for 1 unit of every asset and no drift.
+        // covariance is assets x assets, row major, of log returns over the horizon (daily variance for a 1 day VaR).
+        RiskEngine(const Portfolio& portfolio, std::span<const double> quantities, std::span<const double> drift, std::span<const double> covariance)
+            : assets_(static_cast<size_t>(portfolio.getSize())), startValue_(0.0), factor_(choleskyFactor(covariance, assets_)) {
+            if ((!quantities.empty() && quantities.size() != this->assets_) || (!drift.empty() && drift.size() != this->assets_)) {
+                throw std::invalid_argument("Need one quantity and one drift per asset");
+            }
+            for (size_t i = 0; i < this->assets_; i++) {
+                double held = portfolio.prices()[i] * (quantities.empty() ? 1.0 : quantities[i]);
+                double mean = (drift.empty() ? 0.0 : drift[i]) - 0.5 * covariance[i * this->assets_ + i];
+                this->startValue_ += held;
+                this->weights_.push_back(held * std::exp(mean));
+            }
+        }
+
+        double getStartValue() const {
+            return this->startValue_;
+        }
+
+        // Loss (start value - end value) of every path, paths split between threadCount threads in batches of riskBatch.
+        // Batch n always uses the engine's Philox stream n of seed (see riskStreamTag), so the losses are the same
+        // for any thread count.
+        std::vector<double> simulateLosses(size_t paths, uint64_t seed, unsigned threadCount, const RiskKernels& kernels = bestRiskKernels()) const {
+            std::vector<double> losses(paths);
+            size_t batches = (paths + riskBatch - 1) / riskBatch;
+            if (batches > std::numeric_limits<uint32_t>::max()) {
+                throw std::invalid_argument("Too many paths: batch numbers must fit below riskStreamTag");
+            }
+            threadCount = static_cast<unsigned>(std::min<size_t>(std::max(threadCount, 1u), std::max<size_t>(batches, 1)));
+            std::atomic<size_t> nextBatch{0}; // threads take the next batch when done, so a slow thread holds nobody up
+            auto work = [&] {
+                std::vector<uint32_t> raw(this->assets_ * riskBatch * 2);
+                AlignedPrices z = allocateAlignedPrices(this->assets_ * riskBatch);
+                AlignedPrices x = allocateAlignedPrices(this->assets_ * riskBatch);
+                AlignedPrices values = allocateAlignedPrices(riskBatch);
+                for (size_t batch = nextBatch++; batch < batches; batch = nextBatch++) {
+                    size_t first = batch * riskBatch;
+                    size_t count = std::min(riskBatch, paths - first);
+                    this->simulateBatch(batch, count, seed, kernels, raw, z.get(), x.get(), values.get(), losses.data() + first);
+                }
+            };
+            std::vector<std::thread> threads;
+            for (unsigned t = 1; t < threadCount; t++) {
+                threads.emplace_back(work);
+            }
+            work(); // the calling thread works too
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            return losses;
+        }
+
+        // VaR and expected shortfall at each confidence level (in (0, 1)) from the simulated losses.
+        // Only the tail beyond the lowest confidence level gets sorted, the rest is partitioned in linear time.
+        static std::vector<RiskMeasure> measure(std::vector<double> losses, std::span<const double> confidences) {
+            if (losses.empty() || confidences.empty()) {
+                return {};
+            }
+            for (double confidence : confidences) {
+                if (!(confidence > 0.0 && confidence < 1.0)) {
+                    throw std::invalid_argument("Confidence must be between 0 and 1");
+                }
+            }
+            auto tailStart = [&](double confidence) {
+                return std::min(losses.size() - 1, static_cast<size_t>(confidence * losses.size()));
+            };
+            size_t first = tailStart(*std::min_element(confidences.begin(), confidences.end()));
+            std::nth_element(losses.begin(), losses.begin() + first, losses.end());
+            std::sort(losses.begin() + first, losses.end());
+
+            std::vector<RiskMeasure> measures;
+            for (double confidence : confidences) {
+                size_t start = tailStart(confidence);
+                double tailSum = 0.0;
+                for (size_t i = start; i < losses.size(); i++) {
+                    tailSum += losses[i];
+                }
+                measures.push_back({confidence, losses[start], tailSum / (losses.size() - start)});
+            }
+            return measures;
+        }
+
+        std::vector<RiskMeasure> simulate(size_t paths, std::span<const double> confidences, uint64_t seed, unsigned threadCount,
+                                          const RiskKernels& kernels = bestRiskKernels()) const {
+            return measure(this->simulateLosses(paths, seed, threadCount, kernels), confidences);
+        }
+};
+
+// --- Benchmarks ---
+
+template <typename F>
+double timeSeconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Same data as Portfolio, but declaring the copy operations hides the move ones,
+// so containers have to deep-copy it: this is what Portfolio was before it had a move constructor.
+struct CopyOnlyPortfolio {
+    Portfolio portfolio;
+
+    explicit CopyOnlyPortfolio(Portfolio p) : portfolio(std::move(p)) {}
+    CopyOnlyPortfolio(const CopyOnlyPortfolio&) = default;
+    CopyOnlyPortfolio& operator=(const CopyOnlyPortfolio&) = default;
+};
+
+// Pushes count portfolios of the given size into a vector that was not reserved, so it reallocates
+// about log2(count) times and has to carry every element already in it over to the new block.
+template <typename Element>
+void runGrowBenchmark(const char* name, int count, int size) {
+    std::vector<Element> sources;
+    sources.reserve(count);
+    for (int i = 0; i < count; i++) {
+        sources.emplace_back(Portfolio(size));
+    }
+
+    std::vector<Element> grown;
+    Portfolio::copies = 0;
+    Portfolio::moves = 0;
+    double seconds = timeSeconds([&] {
+        for (Element& element : sources) {
+            grown.push_back(std::move(element));
+        }
+    });
+    std::cout << name << ", " << count << " portfolios of " << size << " prices: " << seconds * 1e3 << " ms, "
+              << Portfolio::copies << " deep copies, " << Portfolio::moves << " moves" << std::endl;
+}
+
+// Times every kernel set on price arrays from 16 elements (fits in registers and L1) up to maxSize
+// (far bigger than the caches, where memory bandwidth caps every version). Reports ns per element.
+void runPriceKernelBenchmark(size_t maxSize) {
+    std::vector<size_t> sizes;
+    for (size_t n = 16; n < maxSize; n *= 4) {
+        sizes.push_back(n);
+    }
+    sizes.push_back(maxSize);
+
+    std::mt19937 eng(42); // fixed seed for reproducibility
+    std::uniform_real_distribution<double> priceDistr(100.0, 500.0);
+    std::uniform_real_distribution<double> returnDistr(-0.01, 0.01);
+    // undo[i] is the return that takes a price back to where it was before returns[i]
+    std::vector<double> prices(maxSize), returns(maxSize), undo(maxSize);
+    for (size_t i = 0; i < maxSize; i++) {
+        prices[i] = priceDistr(eng);
+        returns[i] = returnDistr(eng);
+        undo[i] = 1.0 / (1.0 + returns[i]) - 1.0;
+    }
+
+    double checksum = 0.0; // printed at the end so the compiler cannot drop any of the timed work
+    for (size_t n : sizes) {
+        size_t repeats = std::max<size_t>(1, 100'000'000 / n); // about 10^8 elements per measurement
+        std::span<const double> firstN(prices.data(), n);
+        double reference = 0.0;
+        for (const PriceKernels& kernels : availablePriceKernels()) {
+            Portfolio portfolio(firstN);
+            auto perElement = [&](auto&& op) {
+                return timeSeconds([&] {
+                    for (size_t r = 0; r < repeats; r++) {
+                        op(r);
+                    }
+                }) / (static_cast<double>(repeats) * n) * 1e9;
+            };
+            double sumNs = perElement([&](size_t) { checksum += portfolio.getSum(kernels); });
+            double varianceNs = perElement([&](size_t) { checksum += portfolio.getVariance(kernels); });
+            double minMaxNs = perElement([&](size_t) { checksum += portfolio.getMinPrice(kernels); });
+            // alternating a return with its opposite keeps the prices from drifting off to infinity
+            // (or into slow denormals) over millions of repeats
+            double scaleNs = perElement([&](size_t r) { portfolio.applyReturn(r % 2 == 0 ? 0.001 : 1.0 / 1.001 - 1.0, kernels); });
+            double compoundNs = perElement([&](size_t r) {
+                portfolio.applyReturns(std::span<const double>(r % 2 == 0 ? returns.data() : undo.data(), n), kernels);
+            });
+
+            // the kernels add in different orders, so allow for rounding
+            Portfolio check(firstN);
+            if (reference == 0.0) {
+                reference = check.getVariance(kernels);
+            }
+            bool same = std::abs(check.getVariance(kernels) - reference) <= 1e-9 * reference;
+            std::cout << "n=" << n << " " << kernels.name << ": sum " << sumNs << ", variance " << varianceNs << ", min/max " << minMaxNs
+                      << ", *=(1+r) " << scaleNs << ", *=(1+r[i]) " << compoundNs << " ns/element"
+                      << (same ? "" : " (variance DIFFERENT from scalar)") << std::endl;
+            checksum += portfolio.getSum();
+        }
+    }
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+}
+
+// Compares the old way of filling prices (random_int per element: a fresh uniform_int_distribution on a shared
+// mt19937 every call) with Philox, on one big array and on many small simulated portfolios, for 1 thread up to
+// twice the hardware threads. Every Philox result is compared with the single threaded one.
+void runRandomBenchmark(size_t elementCount, size_t portfolioCount) {
+    unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t <= 2 * hardwareThreads && t <= 64; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    if (threadCounts.size() < 3) {
+        threadCounts.insert(threadCounts.end(), {4, 8}); // even on small machines, to show the output does not change
+    }
+
+    std::vector<double> prices(elementCount);
+    double seconds = timeSeconds([&] {
+        for (double& price : prices) {
+            price = random_int(100, 500);
+        }
+    });
+    std::cout << elementCount << " prices, random_int per element: " << seconds / elementCount * 1e9 << " ns/price" << std::endl;
+
+    PhiloxStream rng(Portfolio::defaultSeed, 0);
+    std::vector<double> reference(elementCount);
+    rng.fillUniformInt(reference, 100, 500, 1);
+    auto toPrice = [](uint32_t r) { return static_cast<double>(100 + ((r * uint64_t{401}) >> 32)); };
+    for (const PhiloxKernelInfo& kernel : availablePhiloxKernels()) {
+        seconds = timeSeconds([&] { rng.fill(prices, 0, toPrice, kernel.kernel); });
+        std::cout << elementCount << " prices, Philox " << kernel.name << " kernel, 1 thread: " << seconds / elementCount * 1e9 << " ns/price"
+                  << (prices == reference ? "" : " (DIFFERENT from the default kernel)") << std::endl;
+    }
+    for (unsigned threadCount : threadCounts) {
+        std::fill(prices.begin(), prices.end(), 0.0);
+        seconds = timeSeconds([&] { rng.fillUniformInt(prices, 100, 500, threadCount); });
+        std::cout << elementCount << " prices, Philox, " << threadCount << " threads: " << seconds / elementCount * 1e9 << " ns/price"
+                  << (prices == reference ? " (same as 1 thread)" : " (DIFFERENT from 1 thread)") << std::endl;
+    }
+
+    const int size = 8; // small enough to live inside the Portfolio object, so this measures generation, not malloc
+    seconds = timeSeconds([&] {
+        std::vector<Portfolio> portfolios;
+        portfolios.reserve(portfolioCount);
+        double generated[size];
+        for (size_t i = 0; i < portfolioCount; i++) {
+            for (double& price : generated) {
+                price = random_int(100, 500);
+            }
+            portfolios.emplace_back(std::span<const double>(generated, size));
+        }
+    });
+    std::cout << portfolioCount << " portfolios of " << size << ", random_int per element: " << seconds * 1e3 << " ms" << std::endl;
+
+    std::vector<Portfolio> first = simulatePortfolios(portfolioCount, size, Portfolio::defaultSeed, 1);
+    for (unsigned threadCount : threadCounts) {
+        std::vector<Portfolio> portfolios;
+        seconds = timeSeconds([&] { portfolios = simulatePortfolios(portfolioCount, size, Portfolio::defaultSeed, threadCount); });
+        bool same = portfolios.size() == first.size();
+        for (size_t i = 0; same && i < portfolios.size(); i++) {
+            same = std::equal(portfolios[i].begin(), portfolios[i].end(), first[i].begin(), first[i].end());
+        }
+        std::cout << portfolioCount << " portfolios of " << size << ", Philox, " << threadCount << " threads: " << seconds * 1e3 << " ms"
+                  << (same ? " (same as 1 thread)" : " (DIFFERENT from 1 thread)") << std::endl;
+    }
+    std::cout << "(" << hardwareThreads << " hardware threads)" << std::endl;
+}
+
+// One day VaR of a random portfolio of assetCount assets under a one factor market (every asset has a beta to
+// the market plus its own noise, which gives a positive definite covariance). Compares the scalar and AVX2 kernels,
+// sweeps the thread count, and checks the result against the delta-normal approximation wTSw.
+void runRiskBenchmark(size_t paths, size_t assetCount, unsigned maxThreads) {
+    const uint64_t seed = 42;
+    Portfolio portfolio(static_cast<int>(assetCount), PhiloxStream(seed, 0));
+    std::vector<double> draws(3 * assetCount);
+    PhiloxStream(seed, 1).fillUniform(draws, 0.0, 1.0);
+    std::vector<double> quantities(assetCount), beta(assetCount), ownVolatility(assetCount);
+    for (size_t i = 0; i < assetCount; i++) {
+        quantities[i] = std::floor(1.0 + 100.0 * draws[i]);
+        beta[i] = 0.5 + draws[assetCount + i];                   // 0.5 .. 1.5
+        ownVolatility[i] = 0.01 + 0.02 * draws[2 * assetCount + i]; // 1% .. 3% a day
+    }
+    const double marketVolatility = 0.01;
+    std::vector<double> covariance(assetCount * assetCount);
+    for (size_t i = 0; i < assetCount; i++) {
+        for (size_t j = 0; j < assetCount; j++) {
+            covariance[i * assetCount + j] = beta[i] * beta[j] * marketVolatility * marketVolatility
+                                           + (i == j ? ownVolatility[i] * ownVolatility[i] : 0.0);
+        }
+    }
+
+    RiskEngine engine(portfolio, quantities, {}, covariance);
+    const std::vector<double> confidences = {0.95, 0.99, 0.999};
+
+    // delta-normal reference: the loss is roughly normal with variance wTSw, w = value held in each asset
+    double variance = 0.0;
+    for (size_t i = 0; i < assetCount; i++) {
+        for (size_t j = 0; j < assetCount; j++) {
+            variance += portfolio.prices()[i] * quantities[i] * covariance[i * assetCount + j] * portfolio.prices()[j] * quantities[j];
+        }
+    }
+    std::cout << assetCount << " assets, start value " << engine.getStartValue() << ", delta-normal 1 day VaR 99% "
+              << 2.326347874 * std::sqrt(variance) << std::endl;
+
+    auto report = [&](const std::string& label, size_t n, double seconds, const std::vector<RiskMeasure>& measures) {
+        std::cout << label << ": " << n << " paths in " << seconds << " s, " << n / seconds / 1e3 << " k paths/s";
+        for (const RiskMeasure& m : measures) {
+            std::cout << " | VaR " << m.confidence * 100 << "% " << m.valueAtRisk << ", ES " << m.expectedShortfall;
+        }
+        std::cout << std::endl;
+    };
+
+    // the scalar kernels get fewer paths, the rate is what gets compared
+    for (const RiskKernels& kernels : availableRiskKernels()) {
+        size_t n = std::string_view(kernels.name) == "scalar" ? std::min<size_t>(paths, 100'000) : paths;
+        std::vector<RiskMeasure> measures;
+        double seconds = timeSeconds([&] { measures = engine.simulate(n, confidences, seed, maxThreads, kernels); });
+        report(std::string(kernels.name) + " kernels, " + std::to_string(maxThreads) + " threads", n, seconds, measures);
+    }
+
+    std::vector<double> reference;
+    for (unsigned threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        std::vector<double> losses;
+        double seconds = timeSeconds([&] { losses = engine.simulateLosses(paths, seed, threadCount); });
+        if (reference.empty()) {
+            reference = losses;
+        }
+        std::cout << threadCount << " threads: " << seconds << " s, " << paths / seconds / 1e3 << " k paths/s"
+                  << (losses == reference ? " (same losses as 1 thread)" : " (DIFFERENT from 1 thread)") << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    // "bench [portfolios]" compares growing a vector of movable and of copy-only portfolios
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        int count = argc > 2 ? std::stoi(argv[2]) : 1'000'000;
+        for (int size : {4, Portfolio::smallCapacity, 100, 1000}) {
+            int scaled = size >= 1000 ? count / 10 : count; // keeps the biggest case under a gigabyte
+            runGrowBenchmark<Portfolio>("movable  ", scaled, size);
+            runGrowBenchmark<CopyOnlyPortfolio>("copy-only", scaled, size);
+        }
+        return 0;
+    }
+    // "bench-simd [max elements]" sweeps the price array kernels over sizes from 16 elements up
+    if (argc > 1 && std::string(argv[1]) == "bench-simd") {
+        runPriceKernelBenchmark(argc > 2 ? std::stoul(argv[2]) : 10'000'000);
+        return 0;
+    }
+    // "bench-risk [paths] [assets] [threads]" times the Monte Carlo VaR engine
+    if (argc > 1 && std::string(argv[1]) == "bench-risk") {
+        runRiskBenchmark(argc > 2 ? std::stoul(argv[2]) : 1'000'000, argc > 3 ? std::stoul(argv[3]) : 500,
+                         argc > 4 ? static_cast<unsigned>(std::stoul(argv[4])) : std::max(1u, std::thread::hardware_concurrency()));
+        return 0;
+    }
+    // "bench-rng [prices] [portfolios]" compares random_int with the parallel Philox generator
+    if (argc > 1 && std::string(argv[1]) == "bench-rng") {
+        runRandomBenchmark(argc > 2 ? std::stoul(argv[2]) : 10'000'000, argc > 3 ? std::stoul(argv[3]) : 1'000'000);
+        return 0;
+    }
 
     std::cout << "Start of program" << std::endl;
 
@@ -103,6 +1464,50 @@ int main() {
     std::cout << "Copied Portfolio:" << std::endl;
     copiedPortfolio.print();
 
+    // moving hands the prices over without copying them, the moved-from portfolio is left empty
+    Portfolio movedPortfolio = std::move(copiedPortfolio);
+    std::cout << "Moved Portfolio (average $" << movedPortfolio.getAveragePrice() << "), "
+              << copiedPortfolio.getSize() << " positions left in the source" << std::endl;
+    try {
+        copiedPortfolio.getAveragePrice();
+    } catch (const std::out_of_range& e) {
+        std::cout << "Average of the moved-from portfolio: " << e.what() << std::endl;
+    }
+
+    // the span accessor works with standard algorithms and range-for
+    Portfolio bigPortfolio(20);
+    auto [lowest, highest] = std::minmax_element(bigPortfolio.begin(), bigPortfolio.end());
+    std::cout << "Big Portfolio: " << bigPortfolio.getSize() << " positions, " << (bigPortfolio.isSmall() ? "inline" : "on the heap")
+              << ", lowest $" << *lowest << ", highest $" << *highest << std::endl;
+
+    // bulk statistics and updates run over the whole array at once (AVX2 when the CPU has it)
+    std::cout << "Big Portfolio average $" << bigPortfolio.getAveragePrice() << ", standard deviation $" << std::sqrt(bigPortfolio.getVariance())
+              << " (" << bestPriceKernels().name << " kernels)" << std::endl;
+    bigPortfolio.applyReturn(0.05);
+    std::cout << "After a 5% return: lowest $" << bigPortfolio.getMinPrice() << ", highest $" << bigPortfolio.getMaxPrice() << std::endl;
+
+    std::vector<Portfolio> portfolios;
+    for (int i = 0; i < 10; i++) {
+        portfolios.push_back(Portfolio(3)); // each one is moved in, and moved again whenever the vector grows
+    }
+    std::cout << "Copies made: " << Portfolio::copies << ", moves made: " << Portfolio::moves << std::endl;
+
+    // one day risk of holding 10 of each asset of myPortfolio: 2% daily volatility each, correlation 0.5
+    const size_t assets = static_cast<size_t>(myPortfolio.getSize());
+    std::vector<double> covariance(assets * assets);
+    for (size_t i = 0; i < assets; i++) {
+        for (size_t j = 0; j < assets; j++) {
+            covariance[i * assets + j] = 0.02 * 0.02 * (i == j ? 1.0 : 0.5);
+        }
+    }
+    std::vector<double> quantities(assets, 10.0);
+    RiskEngine risk(myPortfolio, quantities, {}, covariance);
+    const double confidences[] = {0.95, 0.99};
+    for (const RiskMeasure& measure : risk.simulate(100'000, confidences, Portfolio::defaultSeed, std::thread::hardware_concurrency())) {
+        std::cout << "1 day VaR " << measure.confidence * 100 << "%: $" << measure.valueAtRisk
+                  << ", expected shortfall: $" << measure.expectedShortfall << std::endl;
+    }
+
     std::cout << "End of program" << std::endl;
 
     return 0;
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Shared by the pi programs (pi_approximation.cpp and the SFML visualization) and anything else that needs
+// a Monte Carlo integral. Everything is a template or inline, so including it is all it takes.
+//
+// MonteCarloIntegrator<Dim, F> estimates the integral of F over a Dim-dimensional box. Dim and F are template
+// parameters, so the compiler sees the integrand inside the sampling loop: it gets inlined, the point array has a
+// fixed size and there is no call through a pointer per sample.
+
+// xoshiro256+ (Blackman and Vigna): 4 words of state, a handful of adds, shifts and xors per number, which is
+// several times cheaper than mt19937 and plenty for floating point Monte Carlo (the + variant's weak low bits
+// are thrown away when turning a number into a double).
+// jump() moves the generator 2^128 numbers ahead in about a thousand steps. Starting stream n from the seed jumped
+// n times gives as many streams as needed that are guaranteed not to overlap: no thread will ever get 2^128 numbers.
+struct Xoshiro256Plus {
+    uint64_t s[4];
+
+    // splitmix64 spreads the seed over the 4 words, the state must not be all zeros
+    explicit Xoshiro256Plus(uint64_t seed) {
+        for (uint64_t& word : s) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = s[0] + s[3];
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = std::rotl(s[3], 45);
+        return result;
+    }
+
+    void jump() {
+        static constexpr uint64_t polynomial[] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+        uint64_t jumped[4] = {0, 0, 0, 0};
+        for (uint64_t word : polynomial) {
+            for (int bit = 0; bit < 64; bit++) {
+                if (word & (1ULL << bit)) {
+                    for (int i = 0; i < 4; i++) {
+                        jumped[i] ^= s[i];
+                    }
+                }
+                next();
+            }
+        }
+        std::copy(jumped, jumped + 4, s);
+    }
+};
+
+// Each chunk of samples is generated by 4 independent xoshiro streams side by side, one per lane of a SIMD register.
+// word[w][lane] is word w of the state of lane's stream.
+struct StreamLanes {
+    uint64_t word[4][4];
+};
+
+// Top 52 bits of a random number as a double in [0, 1): the bits go into the mantissa of 1.0, minus 1.
+// The same trick works 4 lanes at a time in AVX2, which has no 64-bit integer to double conversion.
+inline double unitInterval(uint64_t bits) {
+    return std::bit_cast<double>((bits >> 12) | 0x3FF0000000000000ULL) - 1.0;
+}
+
+// Streams for chunks 0 .. chunks - 1: chunk c gets the generator seeded with seed, jumped 4c .. 4c + 3 times.
+// Whichever thread runs a chunk draws the same numbers, so results depend on the seed only, not on the thread count.
+// The jumps have to be done in order, so they are prepared up front (about a microsecond each).
+inline std::vector<StreamLanes> jumpedStreams(uint64_t seed, uint64_t chunks) {
+    std::vector<StreamLanes> streams(chunks);
+    Xoshiro256Plus generator(seed);
+    for (StreamLanes& stream : streams) {
+        for (int lane = 0; lane < 4; lane++) {
+            for (int w = 0; w < 4; w++) {
+                stream.word[w][lane] = generator.s[w];
+            }
+            generator.jump();
+        }
+    }
+    return streams;
+}
+
+// Steps the 4 lanes once and writes one number from each, as a double in [0, 1), to out[0 .. 3].
+// Written lane by lane over plain arrays so the compiler can keep the 4 streams in one vector register.
+inline void nextUniforms(StreamLanes& lanes, double* out) {
+    uint64_t (&s)[4][4] = lanes.word;
+    for (int lane = 0; lane < 4; lane++) {
+        uint64_t result = s[0][lane] + s[3][lane];
+        uint64_t t = s[1][lane] << 17;
+        s[2][lane] ^= s[0][lane];
+        s[3][lane] ^= s[1][lane];
+        s[1][lane] ^= s[2][lane];
+        s[0][lane] ^= s[3][lane];
+        s[2][lane] ^= t;
+        s[3][lane] = std::rotl(s[3][lane], 45);
+        out[lane] = unitInterval(result);
+    }
+}
+
+// Runs work(c) for every chunk c in 0 .. chunks - 1 on threadCount threads (the calling thread is one of them).
+// Threads take the next chunk from an atomic counter, so a slow chunk does not hold the others up. work writes its
+// result to a slot of its own for chunk c; adding the slots up in chunk order afterwards keeps the result
+// independent of which thread ran which chunk.
+template <typename Work>
+void runChunks(uint64_t chunks, unsigned threadCount, Work work) {
+    std::atomic<uint64_t> nextChunk{0};
+    auto worker = [&] {
+        for (uint64_t c = nextChunk++; c < chunks; c = nextChunk++) {
+            work(c);
+        }
+    };
+    threadCount = static_cast<unsigned>(std::min<uint64_t>(std::max(threadCount, 1u), chunks));
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+// Axis aligned box [lower[d], upper[d]) in every dimension d.
+template <size_t Dim>
+struct Box {
+    std::array<double, Dim> lower;
+    std::array<double, Dim> upper;
+
+    // [0, 1)^Dim
+    static Box unit() {
+        Box box;
+        box.lower.fill(0.0);
+        box.upper.fill(1.0);
+        return box;
+    }
+
+    // [-halfWidth, halfWidth)^Dim
+    static Box centered(double halfWidth) {
+        Box box;
+        box.lower.fill(-halfWidth);
+        box.upper.fill(halfWidth);
+        return box;
+    }
+
+    double volume() const {
+        double volume = 1.0;
+        for (size_t d = 0; d < Dim; d++) {
+            volume *= this->upper[d] - this->lower[d];
+        }
+        return volume;
+    }
+};
+
+struct IntegrationResult {
+    double value;
+    double standardError;
+    uint64_t samples;
+};
+
+// F is anything callable as double(const std::array<double, Dim>&), a lambda or a struct with operator().
+// integrate() splits the samples into chunks with their own jumped streams (see jumpedStreams), runs the chunks on
+// threadCount threads and adds the per chunk sums up in chunk order at the end: the same seed and sample count give
+// the same bits on any number of threads.
+template <size_t Dim, typename F>
+class MonteCarloIntegrator {
+    private:
+        static_assert(Dim > 0, "need at least one dimension");
+
+        // points are generated this many at a time: Dim * pointBlock numbers in a buffer that stays in L1
+        static constexpr size_t pointBlock = 64;
+        static constexpr uint64_t chunkSamples = 1 << 20;
+
+        F integrand_;
+        Box<Dim> box_;
+        uint64_t seed_;
+
+        struct ChunkSums {
+            double sum = 0.0;
+            double sumSquares = 0.0;
+        };
+
+        // samples must be a multiple of pointBlock
+        ChunkSums runChunk(StreamLanes& lanes, uint64_t samples) const {
+            std::array<double, Dim> width;
+            for (size_t d = 0; d < Dim; d++) {
+                width[d] = this->box_.upper[d] - this->box_.lower[d];
+            }
+            alignas(32) double uniforms[Dim * pointBlock];
+            alignas(32) double values[pointBlock];
+            // 4 partial sums each, so the adds do not wait on each other
+            double sums[4] = {0.0, 0.0, 0.0, 0.0};
+            double sumSquares[4] = {0.0, 0.0, 0.0, 0.0};
+            for (uint64_t done = 0; done < samples; done += pointBlock) {
+                for (size_t i = 0; i < Dim * pointBlock; i += 4) {
+                    nextUniforms(lanes, uniforms + i);
+                }
+                for (size_t j = 0; j < pointBlock; j++) {
+                    std::array<double, Dim> point;
+                    for (size_t d = 0; d < Dim; d++) {
+                        point[d] = this->box_.lower[d] + width[d] * uniforms[j * Dim + d];
+                    }
+                    values[j] = this->integrand_(point);
+                }
+                for (size_t j = 0; j < pointBlock; j += 4) {
+                    for (int l = 0; l < 4; l++) {
+                        sums[l] += values[j + l];
+                        sumSquares[l] += values[j + l] * values[j + l];
+                    }
+                }
+            }
+            return {(sums[0] + sums[1]) + (sums[2] + sums[3]), (sumSquares[0] + sumSquares[1]) + (sumSquares[2] + sumSquares[3])};
+        }
+
+    public:
+        explicit MonteCarloIntegrator(F integrand, Box<Dim> box = Box<Dim>::unit(), uint64_t seed = 42)
+            : integrand_(std::move(integrand)), box_(box), seed_(seed) {
+            for (size_t d = 0; d < Dim; d++) {
+                if (!(box.lower[d] < box.upper[d])) {
+                    throw std::invalid_argument("box must have lower < upper in every dimension");
+                }
+            }
+        }
+
+        const Box<Dim>& getBox() const {
+            return this->box_;
+        }
+
+        // Integral of F over the box from samples random points (rounded up to whole blocks) on threadCount threads.
+        IntegrationResult integrate(uint64_t samples, unsigned threadCount = 1) const {
+            samples = std::max<uint64_t>(pointBlock, (samples + pointBlock - 1) / pointBlock * pointBlock);
+            uint64_t chunks = (samples + chunkSamples - 1) / chunkSamples;
+            std::vector<StreamLanes> streams = jumpedStreams(this->seed_, chunks);
+            std::vector<ChunkSums> results(chunks);
+            runChunks(chunks, threadCount, [&](uint64_t c) {
+                results[c] = this->runChunk(streams[c], std::min(chunkSamples, samples - c * chunkSamples));
+            });
+
+            double sum = 0.0;
+            double sumSquares = 0.0;
+            for (const ChunkSums& chunk : results) {
+                sum += chunk.sum;
+                sumSquares += chunk.sumSquares;
+            }
+            double n = static_cast<double>(samples);
+            double mean = sum / n;
+            double variance = std::max(0.0, (sumSquares - sum * mean) / (n - 1));
+            double volume = this->box_.volume();
+            return {volume * mean, volume * std::sqrt(variance / n), samples};
+        }
+};
+
+// --- Pi, the classic example ---
+
+// The quarter circle test used by every pi program: is (x, y) within distance 1 of the origin?
+// Comparing the squared distance with 1 gives the same answer as sqrt or hypot without computing either.
+struct QuarterCircle {
+    static bool inside(double x, double y) {
+        return x * x + y * y <= 1.0;
+    }
+
+    double operator()(const std::array<double, 2>& point) const {
+        return inside(point[0], point[1]) ? 1.0 : 0.0;
+    }
+};
+
+// The quarter circle covers pi / 4 of the unit square, so pi is 4 times its integral.
+inline IntegrationResult integratePi(uint64_t samples, unsigned threadCount = 1, uint64_t seed = 42) {
+    MonteCarloIntegrator<2, QuarterCircle> integrator(QuarterCircle{}, Box<2>::unit(), seed);
+    IntegrationResult quarter = integrator.integrate(samples, threadCount);
+    return {4.0 * quarter.value, 4.0 * quarter.standardError, quarter.samples};
+}
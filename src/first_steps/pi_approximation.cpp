@@ -2,6 +2,34 @@
 #include <cmath>
 #include <random>
 #include <limits>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <bit>
+#include <algorithm>
+#include <array>
+#include <numbers>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HAS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions that opt in with a target attribute,
+// which lets one binary carry both kernels and pick one at runtime. MSVC always allows the intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_ATTRIBUTE(isa) __attribute__((target(isa)))
+#else
+#define TARGET_ATTRIBUTE(isa)
+#endif
+
+#include "monte_carlo_integrator.hpp"
 
 // Accept a reference to an array of exactly 2 doubles.
 // This avoids array-to-pointer decay and guarantees size at compile time.
@@ -42,7 +70,606 @@ double random_double(double lowerBound, double upperBound) {
     return distr(eng);
 }
 
-int main() {
+// --- Parallel estimator ---
+
+// Points are generated this many at a time into a small buffer (stays in L1) and then tested.
+constexpr size_t pointBlock = 256;
+
+// Kernel: generates `points` 2-D points in [0, 1)^2 from lanes (points must be a multiple of pointBlock)
+// and returns how many fall inside the quarter circle, comparing the squared distance with 1 (no sqrt needed).
+using CountInsideKernel = uint64_t (*)(StreamLanes& lanes, size_t points);
+
+uint64_t countInsideScalar(StreamLanes& lanes, size_t points) {
+    uint64_t inside = 0;
+    double buffer[2 * pointBlock];
+    for (size_t done = 0; done < points; done += pointBlock) {
+        // step the 4 lanes round robin, number 4 * step + lane of the block comes from lane, like the AVX2 version
+        for (size_t step = 0; step < 2 * pointBlock / 4; step++) {
+            for (int lane = 0; lane < 4; lane++) {
+                uint64_t* s[4] = {&lanes.word[0][lane], &lanes.word[1][lane], &lanes.word[2][lane], &lanes.word[3][lane]};
+                uint64_t result = *s[0] + *s[3];
+                uint64_t t = *s[1] << 17;
+                *s[2] ^= *s[0];
+                *s[3] ^= *s[1];
+                *s[1] ^= *s[2];
+                *s[0] ^= *s[3];
+                *s[2] ^= t;
+                *s[3] = std::rotl(*s[3], 45);
+                buffer[4 * step + lane] = unitInterval(result);
+            }
+        }
+        for (size_t j = 0; j < pointBlock; j++) {
+            double x = buffer[2 * j];
+            double y = buffer[2 * j + 1];
+            inside += QuarterCircle::inside(x, y);
+        }
+    }
+    return inside;
+}
+
+#if defined(HAS_X86_SIMD)
+TARGET_ATTRIBUTE("avx2")
+uint64_t countInsideAvx2(StreamLanes& lanes, size_t points) {
+    __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.word[0]));
+    __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.word[1]));
+    __m256i s2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.word[2]));
+    __m256i s3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.word[3]));
+    const __m256i oneBits = _mm256_set1_epi64x(0x3FF0000000000000LL);
+    const __m256d one = _mm256_set1_pd(1.0);
+    uint64_t inside = 0;
+    alignas(32) double buffer[2 * pointBlock];
+    for (size_t done = 0; done < points; done += pointBlock) {
+        for (size_t step = 0; step < 2 * pointBlock / 4; step++) {
+            __m256i result = _mm256_add_epi64(s0, s3);
+            __m256i t = _mm256_slli_epi64(s1, 17);
+            s2 = _mm256_xor_si256(s2, s0);
+            s3 = _mm256_xor_si256(s3, s1);
+            s1 = _mm256_xor_si256(s1, s2);
+            s0 = _mm256_xor_si256(s0, s3);
+            s2 = _mm256_xor_si256(s2, t);
+            s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19)); // rotate left by 45
+            __m256d u = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(result, 12), oneBits)), one);
+            _mm256_store_pd(buffer + 4 * step, u);
+        }
+        // QuarterCircle::inside 4 points at a time.
+        // 8 numbers = 4 points (x, y, x, y, ...): square everything, hadd sums each x^2 with its y^2
+        for (size_t j = 0; j < 2 * pointBlock; j += 8) {
+            __m256d a = _mm256_load_pd(buffer + j);
+            __m256d b = _mm256_load_pd(buffer + j + 4);
+            __m256d squaredDistance = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+            int mask = _mm256_movemask_pd(_mm256_cmp_pd(squaredDistance, one, _CMP_LE_OQ));
+            inside += std::popcount(static_cast<unsigned>(mask));
+        }
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.word[0]), s0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.word[1]), s1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.word[2]), s2);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.word[3]), s3);
+    return inside;
+}
+
+bool cpuSupportsAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    // AVX2 also needs the OS to save the wide registers on context switch (OSXSAVE + XCR0 bits)
+    bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+#endif
+
+struct CountInsideKernelInfo {
+    const char* name;
+    CountInsideKernel kernel;
+};
+
+// Every kernel this CPU can run, slowest first. They all count the same points.
+std::vector<CountInsideKernelInfo> availableCountInsideKernels() {
+    std::vector<CountInsideKernelInfo> kernels = {{"scalar", countInsideScalar}};
+#if defined(HAS_X86_SIMD)
+    if (cpuSupportsAvx2()) kernels.push_back({"avx2", countInsideAvx2});
+#endif
+    return kernels;
+}
+
+// Feature detection runs once, on first use.
+CountInsideKernel bestCountInsideKernel() {
+    static const CountInsideKernel best = availableCountInsideKernels().back().kernel;
+    return best;
+}
+
+struct PiEstimate {
+    double pi;
+    uint64_t samples;
+    uint64_t inside;
+};
+
+// Estimates pi from (about) samples points on threadCount threads.
+// The samples are split into chunks of chunkSamples; chunk c always uses the 4 streams jumped 4c .. 4c + 3 times
+// from the seed, whichever thread runs it, so the estimate depends on seed and samples only, not on the thread count.
+// The threading is runChunks from monte_carlo_integrator.hpp, the same as integratePi; what this adds is the hand
+// written count kernel. integratePi goes through the general integrand path (a double per point, sums and sums of
+// squares) and does about 200 M samples/s, the AVX2 kernel counts about 500-650 M/s, so the fast path stays here.
+PiEstimate estimatePiParallel(uint64_t samples, unsigned threadCount, uint64_t seed = 42, CountInsideKernel kernel = bestCountInsideKernel()) {
+    constexpr uint64_t chunkSamples = 1 << 22; // ~10 ms of work, small enough to balance threads
+    samples = std::max<uint64_t>(pointBlock, (samples + pointBlock - 1) / pointBlock * pointBlock); // whole blocks
+    uint64_t chunks = (samples + chunkSamples - 1) / chunkSamples;
+
+    std::vector<StreamLanes> streams = jumpedStreams(seed, chunks);
+
+    std::vector<uint64_t> counts(chunks);
+    runChunks(chunks, threadCount, [&](uint64_t c) {
+        counts[c] = kernel(streams[c], std::min(chunkSamples, samples - c * chunkSamples));
+    });
+    uint64_t inside = 0;
+    for (uint64_t count : counts) {
+        inside += count;
+    }
+    return {4.0 * static_cast<double>(inside) / static_cast<double>(samples), samples, inside};
+}
+
+// --- Variance reduction ---
+
+// What limits us is how many samples it takes to get the error down, not how fast one sample is.
+// Plain sampling converges like 1/sqrt(n); the other modes get a smaller constant or a better rate for the same points.
+enum class SamplingMode {
+    Plain,          // independent uniform points
+    Antithetic,     // every point (x, y) also uses its mirror (1 - x, 1 - y): one is inside when the other tends not to be
+    Stratified,     // one point in each cell of a 16x16 grid, so no region gets too many or too few points
+    LatinHypercube, // 256 points that hit each of 256 columns and each of 256 rows exactly once
+    ControlVariate, // corrects the estimate by how far x^2 + y^2 (known mean 2/3, strongly correlated) is from its mean
+    Halton,         // quasi random points in bases 2 and 3, randomly shifted
+    Sobol           // quasi random Sobol points, randomly scrambled
+};
+
+constexpr SamplingMode allSamplingModes[] = {SamplingMode::Plain, SamplingMode::Antithetic, SamplingMode::Stratified, SamplingMode::LatinHypercube,
+                                             SamplingMode::ControlVariate, SamplingMode::Halton, SamplingMode::Sobol};
+
+const char* samplingModeName(SamplingMode mode) {
+    switch (mode) {
+        case SamplingMode::Plain: return "plain";
+        case SamplingMode::Antithetic: return "antithetic";
+        case SamplingMode::Stratified: return "stratified";
+        case SamplingMode::LatinHypercube: return "latin";
+        case SamplingMode::ControlVariate: return "control";
+        case SamplingMode::Halton: return "halton";
+        case SamplingMode::Sobol: return "sobol";
+    }
+    return "?";
+}
+
+SamplingMode parseSamplingMode(std::string_view name) {
+    for (SamplingMode mode : allSamplingModes) {
+        if (name == samplingModeName(mode)) {
+            return mode;
+        }
+    }
+    throw std::invalid_argument("unknown sampling mode: " + std::string(name));
+}
+
+// Sobol direction numbers for 2 dimensions, in the 32-bit fixed point form used by the Gray code construction.
+// Dimension 0 is the van der Corput sequence (every m_i = 1), dimension 1 uses the polynomial x + 1 (m_i = 2 m_{i-1} xor m_{i-1}).
+constexpr std::array<std::array<uint32_t, 32>, 2> sobolDirections = [] {
+    std::array<std::array<uint32_t, 32>, 2> directions{};
+    uint32_t m = 1;
+    for (int i = 0; i < 32; i++) {
+        directions[0][i] = 1u << (31 - i);
+        directions[1][i] = m << (31 - i);
+        m = (m << 1) ^ m;
+    }
+    return directions;
+}();
+
+// Digits of index in base, mirrored behind the decimal point: 1, 2, 3, 4 in base 2 are 0.5, 0.25, 0.75, 0.125.
+double radicalInverse(uint64_t index, uint64_t base) {
+    double result = 0.0;
+    double digitValue = 1.0 / static_cast<double>(base);
+    while (index > 0) {
+        result += static_cast<double>(index % base) * digitValue;
+        index /= base;
+        digitValue /= static_cast<double>(base);
+    }
+    return result;
+}
+
+// One interface for every sampling mode: feed it points with addSamples(), read estimate() and standardError() at any time,
+// or let runUntil() keep going until the standard error is below a tolerance.
+// The error is estimated from the data itself. The modes whose points are not independent are grouped so the groups are:
+//   - plain, antithetic, stratified and latin hypercube keep the running sum and sum of squares of independent units
+//     (a point, a mirrored pair, a whole grid, a whole latin hypercube), the error is their standard deviation / sqrt(units)
+//   - control variate also keeps the sums it needs for the best coefficient (covariance / control variance)
+//   - a quasi random sequence has no randomness of its own, so 16 copies of it are run with different random shifts;
+//     the error is the spread of the 16 estimates / sqrt(16)
+// All modes draw their random numbers from the same xoshiro256+ generator as the parallel estimator, one thread.
+class PiEstimator {
+    private:
+        static constexpr int strataPerAxis = 16;
+        static constexpr int latinPoints = 256;
+        static constexpr int quasiReplicates = 16;
+        static constexpr double controlMean = 2.0 / 3.0; // E[x^2 + y^2] for x, y uniform in [0, 1)
+
+        SamplingMode mode_;
+        Xoshiro256Plus generator_;
+        uint64_t points_ = 0;
+
+        uint64_t units_ = 0;
+        double sum_ = 0.0;
+        double sumSquares_ = 0.0;
+
+        double controlSum_ = 0.0;
+        double controlSumSquares_ = 0.0;
+        double productSum_ = 0.0;
+
+        std::vector<int> latinRows_;
+
+        uint64_t quasiIndex_ = 0;
+        uint32_t sobolPoint_[2] = {0, 0};
+        std::array<std::array<uint32_t, 2>, quasiReplicates> sobolScrambles_{};
+        std::array<std::array<double, 2>, quasiReplicates> haltonShifts_{};
+        std::array<uint64_t, quasiReplicates> quasiInside_{};
+
+        double uniform() {
+            return unitInterval(this->generator_.next());
+        }
+
+        static double insideValue(double x, double y) {
+            return QuarterCircle::inside(x, y) ? 4.0 : 0.0; // 4 * inside, so the mean is pi itself
+        }
+
+        void addUnit(double value, uint64_t points) {
+            this->units_++;
+            this->sum_ += value;
+            this->sumSquares_ += value * value;
+            this->points_ += points;
+        }
+
+        // Adds the next point of the quasi random sequence to every replicate, each with its own shift.
+        void addQuasiPoint() {
+            if (this->mode_ == SamplingMode::Sobol) {
+                // digital shift: xor with random bits keeps the Sobol points evenly spread
+                for (int r = 0; r < quasiReplicates; r++) {
+                    double x = (this->sobolPoint_[0] ^ this->sobolScrambles_[r][0]) * 0x1p-32;
+                    double y = (this->sobolPoint_[1] ^ this->sobolScrambles_[r][1]) * 0x1p-32;
+                    this->quasiInside_[r] += QuarterCircle::inside(x, y);
+                }
+                // Gray code order: the next point differs from this one by a single direction number
+                int bit = std::countr_one(this->quasiIndex_);
+                if (bit >= 32) {
+                    throw std::out_of_range("Sobol sequence exhausted (2^32 points per replicate)");
+                }
+                this->sobolPoint_[0] ^= sobolDirections[0][bit];
+                this->sobolPoint_[1] ^= sobolDirections[1][bit];
+            } else {
+                double hx = radicalInverse(this->quasiIndex_, 2);
+                double hy = radicalInverse(this->quasiIndex_, 3);
+                for (int r = 0; r < quasiReplicates; r++) {
+                    // random shift modulo 1
+                    double x = hx + this->haltonShifts_[r][0];
+                    double y = hy + this->haltonShifts_[r][1];
+                    x -= x >= 1.0 ? 1.0 : 0.0;
+                    y -= y >= 1.0 ? 1.0 : 0.0;
+                    this->quasiInside_[r] += QuarterCircle::inside(x, y);
+                }
+            }
+            this->quasiIndex_++;
+            this->points_ += quasiReplicates;
+        }
+
+        // Adds one independent unit (or one quasi random point per replicate), returns nothing: points_ tells how far we got.
+        void step() {
+            switch (this->mode_) {
+                case SamplingMode::Plain: {
+                    double x = this->uniform();
+                    double y = this->uniform();
+                    this->addUnit(insideValue(x, y), 1);
+                    break;
+                }
+                case SamplingMode::Antithetic: {
+                    double x = this->uniform();
+                    double y = this->uniform();
+                    this->addUnit(0.5 * (insideValue(x, y) + insideValue(1.0 - x, 1.0 - y)), 2);
+                    break;
+                }
+                case SamplingMode::Stratified: {
+                    double value = 0.0;
+                    for (int i = 0; i < strataPerAxis; i++) {
+                        for (int j = 0; j < strataPerAxis; j++) {
+                            value += insideValue((i + this->uniform()) / strataPerAxis, (j + this->uniform()) / strataPerAxis);
+                        }
+                    }
+                    this->addUnit(value / (strataPerAxis * strataPerAxis), strataPerAxis * strataPerAxis);
+                    break;
+                }
+                case SamplingMode::LatinHypercube: {
+                    // column i gets a random row; a Fisher-Yates shuffle makes the rows a random permutation
+                    for (int i = latinPoints - 1; i > 0; i--) {
+                        int j = static_cast<int>(this->generator_.next() % static_cast<uint64_t>(i + 1));
+                        std::swap(this->latinRows_[i], this->latinRows_[j]);
+                    }
+                    double value = 0.0;
+                    for (int i = 0; i < latinPoints; i++) {
+                        value += insideValue((i + this->uniform()) / latinPoints, (this->latinRows_[i] + this->uniform()) / latinPoints);
+                    }
+                    this->addUnit(value / latinPoints, latinPoints);
+                    break;
+                }
+                case SamplingMode::ControlVariate: {
+                    double x = this->uniform();
+                    double y = this->uniform();
+                    double control = x * x + y * y;
+                    this->addUnit(insideValue(x, y), 1);
+                    this->controlSum_ += control;
+                    this->controlSumSquares_ += control * control;
+                    this->productSum_ += control * insideValue(x, y);
+                    break;
+                }
+                case SamplingMode::Halton:
+                case SamplingMode::Sobol:
+                    this->addQuasiPoint();
+                    break;
+            }
+        }
+
+        bool isQuasiRandom() const {
+            return this->mode_ == SamplingMode::Halton || this->mode_ == SamplingMode::Sobol;
+        }
+
+        // beta = cov(value, control) / var(control), the coefficient that removes the most variance
+        double controlCoefficient() const {
+            double n = static_cast<double>(this->units_);
+            double covariance = this->productSum_ / n - (this->sum_ / n) * (this->controlSum_ / n);
+            double controlVariance = this->controlSumSquares_ / n - (this->controlSum_ / n) * (this->controlSum_ / n);
+            return controlVariance > 0.0 ? covariance / controlVariance : 0.0;
+        }
+
+    public:
+        explicit PiEstimator(SamplingMode mode, uint64_t seed = 42) : mode_(mode), generator_(seed) {
+            if (mode == SamplingMode::LatinHypercube) {
+                this->latinRows_.resize(latinPoints);
+                for (int i = 0; i < latinPoints; i++) {
+                    this->latinRows_[i] = i;
+                }
+            }
+            for (int r = 0; r < quasiReplicates; r++) {
+                this->sobolScrambles_[r] = {static_cast<uint32_t>(this->generator_.next() >> 32), static_cast<uint32_t>(this->generator_.next() >> 32)};
+                this->haltonShifts_[r] = {this->uniform(), this->uniform()};
+            }
+        }
+
+        SamplingMode getMode() const {
+            return this->mode_;
+        }
+
+        // Total points tested so far (a mirrored pair counts 2, a quasi random point counts once per replicate).
+        uint64_t getPoints() const {
+            return this->points_;
+        }
+
+        // Adds at least points more points (whole units only).
+        void addSamples(uint64_t points) {
+            uint64_t target = this->points_ + points;
+            while (this->points_ < target) {
+                this->step();
+            }
+        }
+
+        double estimate() const {
+            if (this->isQuasiRandom()) {
+                if (this->quasiIndex_ == 0) return 0.0;
+                uint64_t inside = 0;
+                for (uint64_t count : this->quasiInside_) {
+                    inside += count;
+                }
+                return 4.0 * static_cast<double>(inside) / static_cast<double>(this->points_);
+            }
+            if (this->units_ == 0) return 0.0;
+            double n = static_cast<double>(this->units_);
+            double mean = this->sum_ / n;
+            if (this->mode_ == SamplingMode::ControlVariate) {
+                mean -= this->controlCoefficient() * (this->controlSum_ / n - controlMean);
+            }
+            return mean;
+        }
+
+        // Estimated standard deviation of estimate(), infinity until there is enough data to tell.
+        double standardError() const {
+            if (this->isQuasiRandom()) {
+                if (this->quasiIndex_ == 0) return std::numeric_limits<double>::infinity();
+                double sum = 0.0;
+                double sumSquares = 0.0;
+                for (uint64_t count : this->quasiInside_) {
+                    double replicate = 4.0 * static_cast<double>(count) / static_cast<double>(this->quasiIndex_);
+                    sum += replicate;
+                    sumSquares += replicate * replicate;
+                }
+                double variance = (sumSquares - sum * sum / quasiReplicates) / (quasiReplicates - 1);
+                return std::sqrt(std::max(variance, 0.0) / quasiReplicates);
+            }
+            if (this->units_ < 2) return std::numeric_limits<double>::infinity();
+            double n = static_cast<double>(this->units_);
+            double variance = (this->sumSquares_ - this->sum_ * this->sum_ / n) / (n - 1);
+            if (this->mode_ == SamplingMode::ControlVariate) {
+                // what is left after removing the part explained by the control
+                double controlVariance = (this->controlSumSquares_ - this->controlSum_ * this->controlSum_ / n) / (n - 1);
+                variance -= this->controlCoefficient() * this->controlCoefficient() * controlVariance;
+            }
+            return std::sqrt(std::max(variance, 0.0) / n);
+        }
+
+        // "Stop when error < tolerance": adds points in steps until the standard error is below tolerance
+        // or maxPoints were used. Returns whether the tolerance was reached.
+        bool runUntil(double tolerance, uint64_t maxPoints) {
+            // the first check waits for a few thousand points, before that the error estimate itself is too noisy to trust
+            constexpr uint64_t checkEvery = 1 << 16;
+            while (this->points_ < maxPoints) {
+                this->addSamples(std::min(checkEvery, maxPoints - this->points_));
+                if (this->standardError() < tolerance) {
+                    return true;
+                }
+            }
+            return false;
+        }
+};
+
+// --- Benchmarks ---
+
+template <typename F>
+double timeSeconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The original loop: random_double twice per sample and a sqrt per distance, one thread.
+double estimatePiLoop(int samples) {
+    int insideCircle = 0;
+    for (int i = 0; i < samples; i++) {
+        double point[2] = { random_double(0, 1), random_double(0, 1) };
+        if (calculateDistanceFromOrigin(point) <= 1.0) {
+            insideCircle++;
+        }
+    }
+    return 4.0 * insideCircle / samples;
+}
+
+// Samples per second of the original loop, of each kernel on one thread, and of the best kernel from 1 thread
+// up to twice the hardware threads. Every parallel run must give exactly the same count as the single threaded one.
+void runPiBenchmark(uint64_t samples) {
+    const int loopSamples = 20'000'000;
+    double pi = 0.0;
+    double seconds = timeSeconds([&] { pi = estimatePiLoop(loopSamples); });
+    std::cout << "original loop, 1 thread: " << loopSamples / seconds / 1e6 << " M samples/s (pi ~ " << pi << ")" << std::endl;
+
+    for (const CountInsideKernelInfo& kernel : availableCountInsideKernels()) {
+        PiEstimate estimate;
+        seconds = timeSeconds([&] { estimate = estimatePiParallel(samples, 1, 42, kernel.kernel); });
+        std::cout << kernel.name << " kernel, 1 thread: " << estimate.samples / seconds / 1e6 << " M samples/s (pi ~ " << estimate.pi << ")" << std::endl;
+    }
+
+    unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t reference = 0;
+    for (unsigned threadCount = 1; threadCount <= 2 * hardwareThreads; threadCount *= 2) {
+        PiEstimate estimate;
+        seconds = timeSeconds([&] { estimate = estimatePiParallel(samples, threadCount); });
+        if (threadCount == 1) {
+            reference = estimate.inside;
+        }
+        std::cout << threadCount << " threads: " << estimate.samples / seconds / 1e6 << " M samples/s, pi ~ " << estimate.pi
+                  << " (error " << std::abs(estimate.pi - 3.14159265358979323846) << ")"
+                  << (estimate.inside == reference ? "" : " (DIFFERENT count from 1 thread)") << std::endl;
+    }
+    std::cout << "(" << hardwareThreads << " hardware threads)" << std::endl;
+}
+
+// Time to reach a standard error below tolerance for every sampling mode, against plain sampling.
+void runVarianceBenchmark(double tolerance) {
+    const uint64_t maxPoints = 20'000'000'000;
+    double plainSeconds = 0.0;
+    for (SamplingMode mode : allSamplingModes) {
+        PiEstimator estimator(mode);
+        bool converged = false;
+        double seconds = timeSeconds([&] { converged = estimator.runUntil(tolerance, maxPoints); });
+        if (mode == SamplingMode::Plain) {
+            plainSeconds = seconds;
+        }
+        std::cout << samplingModeName(mode) << ": " << (converged ? "" : "NOT converged, ") << estimator.getPoints() << " points, "
+                  << seconds * 1e3 << " ms (" << plainSeconds / seconds << "x plain), pi ~ " << estimator.estimate()
+                  << " +- " << estimator.standardError() << ", actual error " << std::abs(estimator.estimate() - 3.14159265358979323846) << std::endl;
+    }
+}
+
+// Integrand for the integrator benchmark: exp(-|x|^2) over [-1, 1)^Dim, exactly (sqrt(pi) * erf(1))^Dim.
+template <size_t Dim>
+struct Gaussian {
+    double operator()(const std::array<double, Dim>& point) const {
+        double squaredNorm = 0.0;
+        for (size_t d = 0; d < Dim; d++) {
+            squaredNorm += point[d] * point[d];
+        }
+        return std::exp(-squaredNorm);
+    }
+};
+
+// Integrand for the integrator benchmark: inside the unit ball, volume pi^(Dim/2) / Gamma(Dim/2 + 1).
+// The ball fills less and less of the box as Dim grows (1.6e-4 of it in 12-D, 3.6e-6 in 16-D), which is
+// what makes high dimensional hit-or-miss integrals so noisy.
+template <size_t Dim>
+struct UnitBall {
+    double operator()(const std::array<double, Dim>& point) const {
+        double squaredNorm = 0.0;
+        for (size_t d = 0; d < Dim; d++) {
+            squaredNorm += point[d] * point[d];
+        }
+        return squaredNorm <= 1.0 ? 1.0 : 0.0;
+    }
+};
+
+template <size_t Dim, typename F>
+void runIntegrandBenchmark(const char* name, F integrand, double exact, uint64_t samples) {
+    MonteCarloIntegrator<Dim, F> integrator(integrand, Box<Dim>::centered(1.0));
+    unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    IntegrationResult result;
+    double seconds = timeSeconds([&] { result = integrator.integrate(samples, 1); });
+    IntegrationResult parallel;
+    double parallelSeconds = timeSeconds([&] { parallel = integrator.integrate(samples, hardwareThreads); });
+    std::cout << Dim << "-D " << name << ": " << result.value << " +- " << result.standardError << " (exact " << exact
+              << "), " << result.samples / seconds / 1e6 << " M samples/s on 1 thread, "
+              << parallel.samples / parallelSeconds / 1e6 << " M samples/s on " << hardwareThreads << " threads"
+              << (parallel.value == result.value ? "" : " (DIFFERENT result)") << std::endl;
+}
+
+template <size_t Dim>
+void runDimensionBenchmark(uint64_t samples) {
+    double gaussianExact = std::pow(std::sqrt(std::numbers::pi) * std::erf(1.0), static_cast<double>(Dim));
+    double ballExact = std::pow(std::numbers::pi, Dim / 2.0) / std::tgamma(Dim / 2.0 + 1.0);
+    runIntegrandBenchmark<Dim>("gaussian", Gaussian<Dim>{}, gaussianExact, samples);
+    runIntegrandBenchmark<Dim>("unit ball", UnitBall<Dim>{}, ballExact, samples);
+}
+
+// The integrator on pi, and on two integrands from 2-D to 16-D, each compiled for its dimension.
+void runIntegratorBenchmark(uint64_t samples) {
+    IntegrationResult pi;
+    double seconds = timeSeconds([&] { pi = integratePi(samples); });
+    std::cout << "pi through the integrator: " << pi.value << " +- " << pi.standardError << ", "
+              << pi.samples / seconds / 1e6 << " M samples/s on 1 thread" << std::endl;
+    runDimensionBenchmark<2>(samples);
+    runDimensionBenchmark<4>(samples);
+    runDimensionBenchmark<8>(samples);
+    runDimensionBenchmark<12>(samples);
+    runDimensionBenchmark<16>(samples);
+}
+
+int main(int argc, char* argv[]) {
+    // "bench [samples]" compares the original loop with the parallel estimator
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        runPiBenchmark(argc > 2 ? std::stoull(argv[2]) : 1'000'000'000);
+        return 0;
+    }
+    // "bench-integrator [samples]" runs MonteCarloIntegrator from 2-D to 16-D
+    if (argc > 1 && std::string(argv[1]) == "bench-integrator") {
+        runIntegratorBenchmark(argc > 2 ? std::stoull(argv[2]) : 100'000'000);
+        return 0;
+    }
+    // "bench-variance [tolerance]" times every sampling mode to the same standard error
+    if (argc > 1 && std::string(argv[1]) == "bench-variance") {
+        runVarianceBenchmark(argc > 2 ? std::stod(argv[2]) : 1e-4);
+        return 0;
+    }
+    // "estimate <mode> [tolerance]" samples with one mode until the standard error is below tolerance
+    if (argc > 2 && std::string(argv[1]) == "estimate") {
+        PiEstimator estimator(parseSamplingMode(argv[2]));
+        double tolerance = argc > 3 ? std::stod(argv[3]) : 1e-4;
+        estimator.runUntil(tolerance, 20'000'000'000);
+        std::cout << "Pi ~ " << estimator.estimate() << " +- " << estimator.standardError() << " after " << estimator.getPoints() << " points" << std::endl;
+        return 0;
+    }
+
     int samples = 1'000'000;
 
     int insideCircle = 0;
@@ -72,5 +699,19 @@ int main() {
     double pi = 4.0 * insideCircle / samples;
     std::cout << "Estimated value of Pi: " << pi << std::endl;
 
+    // the same estimate with far more samples, spread over every core
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    PiEstimate parallel = estimatePiParallel(100'000'000, threads);
+    std::cout << "Estimated value of Pi with " << parallel.samples << " samples on " << threads << " threads: " << parallel.pi << std::endl;
+
+    // pi is also just one integral for the generic integrator
+    IntegrationResult integrated = integratePi(100'000'000, threads);
+    std::cout << "Estimated value of Pi with MonteCarloIntegrator: " << integrated.value << " +- " << integrated.standardError << std::endl;
+
+    // or stop as soon as the estimate is good enough, with quasi random points that get there much sooner
+    PiEstimator sobol(SamplingMode::Sobol);
+    sobol.runUntil(1e-6, 1'000'000'000);
+    std::cout << "Estimated value of Pi with Sobol points: " << sobol.estimate() << " +- " << sobol.standardError() << " (" << sobol.getPoints() << " points)" << std::endl;
+
     return 0;
 }
\ No newline at end of file
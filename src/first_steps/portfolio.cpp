@@ -1,17 +1,307 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <string>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <fstream>
+#include <sstream>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <array>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+#include <optional>
+#include <span>
 
-struct Date {
-    int day;
-    int month;
-    int year;
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+
+#include "symbol_table.hpp"
+
+// Calendar date stored as the number of days since 1970-01-01, in 4 bytes instead of three ints.
+// Comparing two dates or counting the days between them is one integer operation, which is what the
+// history index below sorts and searches on. Day, month and year are only worked out again for printing.
+// The conversions are Howard Hinnant's days_from_civil / civil_from_days (proleptic Gregorian calendar).
+class Date {
+    private:
+        int32_t days_ = 0;
+
+        struct Civil {
+            int year;
+            int month;
+            int day;
+        };
+
+        static constexpr int32_t daysFromCivil(int year, int month, int day) {
+            year -= month <= 2; // the computation treats March as the first month, so February 29 is the last day
+            const int era = (year >= 0 ? year : year - 399) / 400;
+            const int yearOfEra = year - era * 400;                                         // [0, 399]
+            const int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+            const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;  // [0, 146096]
+            return era * 146097 + dayOfEra - 719468;
+        }
+
+        constexpr Civil toCivil() const {
+            const int32_t z = this->days_ + 719468;
+            const int era = (z >= 0 ? z : z - 146096) / 146097;
+            const int dayOfEra = z - era * 146097;
+            const int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+            const int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+            const int shiftedMonth = (5 * dayOfYear + 2) / 153; // 0 = March
+            const int day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+            const int month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+            return {yearOfEra + era * 400 + (month <= 2), month, day};
+        }
+
+    public:
+        constexpr Date() = default;
+
+        // Same argument order as before, so {day, month, year} still works.
+        constexpr Date(int day, int month, int year) : days_(daysFromCivil(year, month, day)) {}
+
+        static constexpr Date fromDays(int32_t days) {
+            Date date;
+            date.days_ = days;
+            return date;
+        }
+
+        constexpr int32_t days() const { return this->days_; }
+        constexpr int day() const { return this->toCivil().day; }
+        constexpr int month() const { return this->toCivil().month; }
+        constexpr int year() const { return this->toCivil().year; }
+
+        constexpr auto operator<=>(const Date&) const = default;
+};
+
+static_assert(Date(1, 1, 1970).days() == 0, "day zero");
+static_assert(Date(1, 3, 2024).days() - Date(28, 2, 2024).days() == 2, "leap day");
+static_assert(Date::fromDays(Date(31, 12, 2025).days()).month() == 12, "round trip");
+
+// --- Fixed-point numbers ---
+// Prices and quantities used to be doubles. 0.1 has no exact binary representation, so after a few thousand
+// buys and sells a position that should be empty could hold 1e-13 shares and never be removed, and two equal
+// looking prices could compare unequal. FixedPoint stores a number as a whole count of 1/Scale units in an int64:
+// adding, subtracting and comparing are plain integer instructions and always exact.
+// Only division (the average price) rounds, to the nearest unit.
+// Tag keeps the different kinds apart: adding a Price to a Quantity does not compile.
+template <int64_t Scale, typename Tag>
+class FixedPoint {
+    private:
+        int64_t raw_ = 0;
+
+    public:
+        static constexpr int64_t scale = Scale;
+
+        constexpr FixedPoint() = default;
+
+        // Nearest representable value, e.g. Price(150.25).
+        constexpr explicit FixedPoint(double value)
+            : raw_(static_cast<int64_t>(value * Scale + (value < 0 ? -0.5 : 0.5))) {}
+
+        // Whole units, exact.
+        template <typename Int, typename = std::enable_if_t<std::is_integral_v<Int>>>
+        constexpr explicit FixedPoint(Int value) : raw_(static_cast<int64_t>(value) * Scale) {}
+
+        static constexpr FixedPoint fromRaw(int64_t raw) {
+            FixedPoint result;
+            result.raw_ = raw;
+            return result;
+        }
+
+        // Count of 1/Scale units.
+        constexpr int64_t raw() const { return this->raw_; }
+
+        // For printing and statistics only, never feed it back into the order math.
+        constexpr double toDouble() const { return static_cast<double>(this->raw_) / Scale; }
+
+        constexpr FixedPoint operator+(FixedPoint other) const { return fromRaw(this->raw_ + other.raw_); }
+        constexpr FixedPoint operator-(FixedPoint other) const { return fromRaw(this->raw_ - other.raw_); }
+        constexpr FixedPoint operator-() const { return fromRaw(-this->raw_); }
+        constexpr FixedPoint& operator+=(FixedPoint other) { this->raw_ += other.raw_; return *this; }
+        constexpr FixedPoint& operator-=(FixedPoint other) { this->raw_ -= other.raw_; return *this; }
+
+        constexpr auto operator<=>(const FixedPoint&) const = default;
+
+        friend std::ostream& operator<<(std::ostream& out, FixedPoint value) {
+            return out << value.toDouble();
+        }
+};
+
+struct PriceTag {};
+struct QuantityTag {};
+struct MoneyTag {};
+
+// Change the scales here: prices to 1/10000 of a currency unit, quantities to 1/1000 of a share.
+using Price = FixedPoint<10'000, PriceTag>;
+using Quantity = FixedPoint<1'000, QuantityTag>;
+// Price times quantity. Its scale is the product of both, so the multiplication is exact; the catch is the range,
+// an int64 at this scale holds amounts up to about 9.2e11.
+using Money = FixedPoint<Price::scale * Quantity::scale, MoneyTag>;
+
+constexpr Money operator*(Price price, Quantity quantity) {
+    return Money::fromRaw(price.raw() * quantity.raw());
+}
+
+// cost / quantity rounded to the nearest Price unit, halves away from zero. quantity must not be zero.
+// Money's scale is Price::scale * Quantity::scale, so in raw units this is simply cost.raw() / quantity.raw().
+constexpr Price averagePrice(Money cost, Quantity quantity) {
+    int64_t numerator = cost.raw();
+    int64_t denominator = quantity.raw();
+    if (denominator < 0) {
+        numerator = -numerator;
+        denominator = -denominator;
+    }
+    int64_t half = denominator / 2;
+    return Price::fromRaw(numerator >= 0 ? (numerator + half) / denominator : (numerator - half) / denominator);
+}
+
+static_assert(Price(0.1) + Price(0.2) == Price(0.3), "fixed-point addition is exact");
+static_assert(Price(150.5) * Quantity(2) == Money(301), "price times quantity is exact");
+static_assert(averagePrice(Price(150) * Quantity(10) + Price(160) * Quantity(10), Quantity(20)) == Price(155), "average of two fills");
+
+// Hash map for integer keys stored in one flat array (open addressing with linear probing).
+// std::unordered_map allocates a node per entry and follows a pointer on every lookup,
+// here a lookup hashes the key and scans neighbouring slots, which are usually in the same cache line.
+// emptyKey marks unused slots and can not be used as a real key.
+template <typename Key, typename Value, Key emptyKey = std::numeric_limits<Key>::max()>
+class FlatHashMap {
+    private:
+        struct Slot {
+            Key key;
+            Value value;
+        };
+
+        std::vector<Slot> slots_;
+        size_t size_ = 0;
+        size_t mask_ = 0; // capacity - 1, capacity is always a power of two
+
+        // Fibonacci hashing: multiplying by 2^64 / golden ratio spreads consecutive ids over the whole table
+        size_t slotFor(Key key) const {
+            return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> 32) & this->mask_;
+        }
+
+        void rehash(size_t capacity) {
+            std::vector<Slot> old = std::move(this->slots_);
+            this->slots_.assign(capacity, Slot{emptyKey, Value{}});
+            this->mask_ = capacity - 1;
+            this->size_ = 0;
+            for (const Slot &slot : old) {
+                if (slot.key != emptyKey) {
+                    this->insert(slot.key, slot.value);
+                }
+            }
+        }
+
+    public:
+        FlatHashMap() {
+            this->rehash(16);
+        }
+
+        // Makes room for count entries without further rehashing.
+        void reserve(size_t count) {
+            size_t capacity = this->slots_.size();
+            while (count * 2 > capacity) {
+                capacity *= 2;
+            }
+            if (capacity != this->slots_.size()) {
+                this->rehash(capacity);
+            }
+        }
+
+        // nullptr if key is not in the map
+        Value* find(Key key) {
+            for (size_t i = this->slotFor(key); ; i = (i + 1) & this->mask_) {
+                if (this->slots_[i].key == key) return &this->slots_[i].value;
+                if (this->slots_[i].key == emptyKey) return nullptr;
+            }
+        }
+
+        const Value* find(Key key) const {
+            return const_cast<FlatHashMap*>(this)->find(key);
+        }
+
+        // Inserts key or overwrites its value.
+        void insert(Key key, const Value& value) {
+            // keeping the table at most half full keeps probe sequences short
+            if ((this->size_ + 1) * 2 > this->slots_.size()) {
+                this->rehash(this->slots_.size() * 2);
+            }
+            size_t i = this->slotFor(key);
+            while (this->slots_[i].key != emptyKey && this->slots_[i].key != key) {
+                i = (i + 1) & this->mask_;
+            }
+            if (this->slots_[i].key == emptyKey) {
+                this->size_++;
+            }
+            this->slots_[i] = {key, value};
+        }
+
+        // Removes key if present. Instead of leaving a tombstone, later entries of the same probe run
+        // are shifted back into the gap, so lookups never have to skip over deleted slots.
+        bool erase(Key key) {
+            size_t i = this->slotFor(key);
+            while (this->slots_[i].key != key) {
+                if (this->slots_[i].key == emptyKey) return false;
+                i = (i + 1) & this->mask_;
+            }
+            for (size_t j = (i + 1) & this->mask_; this->slots_[j].key != emptyKey; j = (j + 1) & this->mask_) {
+                size_t home = this->slotFor(this->slots_[j].key);
+                // slot j may move into the gap at i only if its home slot is not inside (i, j], cyclically
+                bool homeBetween = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+                if (!homeBetween) {
+                    this->slots_[i] = this->slots_[j];
+                    i = j;
+                }
+            }
+            this->slots_[i].key = emptyKey;
+            this->size_--;
+            return true;
+        }
+
+        size_t size() const {
+            return this->size_;
+        }
+
+        void clear() {
+            this->slots_.assign(this->slots_.size(), Slot{emptyKey, Value{}});
+            this->size_ = 0;
+        }
 };
 
 struct Position {
-    std::string ticker;
-    double avgPrice;
-    double quantity;
+    SymbolId symbol;
+    Price avgPrice;
+    Quantity quantity;
+    Price markPrice;   // last known market price: the latest tick, or the latest fill if that came after it
+    Money realizedPnl; // profit from sells since the position was opened
+};
+
+// Market price update for one symbol, e.g. the price column of a Ticker row.
+struct PriceTick {
+    SymbolId symbol;
+    Price price;
 };
 
 enum class OrderType {
@@ -20,26 +310,405 @@ enum class OrderType {
 };
 
 struct Order {
-    std::string ticker;
-    double price;
-    double quantity;
+    SymbolId symbol;
+    Price price;
+    Quantity quantity;
     OrderType type;
     Date date;
 };
 
+// --- Order history storage ---
+// A std::vector<Order> that keeps growing reallocates now and then: it allocates a buffer twice the size,
+// copies every order across and frees the old one, so for a moment both copies are alive.
+// For a long session with tens of millions of orders that is a lot of copying and a large memory spike.
+// OrderJournal stores orders in fixed-size chunks instead. A full chunk is never touched again, a new one is
+// added next to it, so appending never copies old orders and a stored order never moves.
+
+// Hands out memory from big blocks by bumping a pointer ("monotonic": nothing is freed one by one).
+// All memory is returned at once by release() or the destructor, so an allocation costs a few instructions
+// and only one malloc happens per block.
+class MonotonicArena {
+    private:
+        std::vector<std::unique_ptr<std::byte[]>> blocks_;
+        size_t blockSize_;
+        std::byte* cursor_ = nullptr;
+        size_t remaining_ = 0;
+
+    public:
+        explicit MonotonicArena(size_t blockSize = 4 * 1024 * 1024) : blockSize_(blockSize) {}
+
+        // The arena owns raw memory that other objects point into, copying it would be a bug.
+        MonotonicArena(const MonotonicArena&) = delete;
+        MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+        void* allocate(size_t bytes, size_t alignment) {
+            size_t padding = (alignment - reinterpret_cast<uintptr_t>(this->cursor_) % alignment) % alignment;
+            if (this->cursor_ == nullptr || padding + bytes > this->remaining_) {
+                // start a new block, anything left in the current one is wasted
+                size_t size = std::max(this->blockSize_, bytes + alignment);
+                this->blocks_.push_back(std::make_unique<std::byte[]>(size));
+                this->cursor_ = this->blocks_.back().get();
+                this->remaining_ = size;
+                padding = (alignment - reinterpret_cast<uintptr_t>(this->cursor_) % alignment) % alignment;
+            }
+            std::byte* result = this->cursor_ + padding;
+            this->cursor_ = result + bytes;
+            this->remaining_ -= padding + bytes;
+            return result;
+        }
+
+        // Frees every block. Everything allocated from the arena is invalid afterwards.
+        void release() {
+            this->blocks_.clear();
+            this->cursor_ = nullptr;
+            this->remaining_ = 0;
+        }
+
+        size_t bytesReserved() const {
+            return this->blocks_.size() * this->blockSize_;
+        }
+};
+
+// Append-only, chunked order storage backed by a MonotonicArena.
+// References to stored orders stay valid until clear().
+class OrderJournal {
+    private:
+        static constexpr size_t ordersPerChunk = 4096;
+
+        MonotonicArena arena_;
+        std::vector<Order*> chunks_; // one pointer per 4096 orders, the only thing that ever gets reallocated
+        size_t size_ = 0;
+
+    public:
+        // Walks the orders in the order they were appended.
+        class Iterator {
+            private:
+                const OrderJournal* journal_;
+                size_t index_;
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = Order;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const Order*;
+                using reference = const Order&;
+
+                Iterator(const OrderJournal* journal, size_t index) : journal_(journal), index_(index) {}
+
+                const Order& operator*() const { return (*this->journal_)[this->index_]; }
+                const Order* operator->() const { return &(*this->journal_)[this->index_]; }
+                Iterator& operator++() { this->index_++; return *this; }
+                Iterator operator++(int) { Iterator copy = *this; this->index_++; return copy; }
+                bool operator==(const Iterator& other) const { return this->index_ == other.index_; }
+                bool operator!=(const Iterator& other) const { return this->index_ != other.index_; }
+        };
+
+        OrderJournal() : arena_(64 * ordersPerChunk * sizeof(Order)) {}
+
+        const Order& append(const Order &order) {
+            if (this->size_ % ordersPerChunk == 0) {
+                void* memory = this->arena_.allocate(ordersPerChunk * sizeof(Order), alignof(Order));
+                this->chunks_.push_back(static_cast<Order*>(memory));
+            }
+            Order* slot = this->chunks_.back() + this->size_ % ordersPerChunk;
+            *slot = order; // Order is trivially copyable, plain assignment into the raw memory is fine
+            this->size_++;
+            return *slot;
+        }
+
+        const Order& operator[](size_t index) const {
+            return this->chunks_[index / ordersPerChunk][index % ordersPerChunk];
+        }
+
+        size_t size() const {
+            return this->size_;
+        }
+
+        bool empty() const {
+            return this->size_ == 0;
+        }
+
+        Iterator begin() const { return Iterator(this, 0); }
+        Iterator end() const { return Iterator(this, this->size_); }
+
+        // Calls f(const Order&) for every order, chunk by chunk, which saves the index arithmetic of the iterator.
+        template <typename F>
+        void forEach(F&& f) const {
+            for (size_t chunk = 0; chunk < this->chunks_.size(); ++chunk) {
+                size_t count = std::min(ordersPerChunk, this->size_ - chunk * ordersPerChunk);
+                for (size_t i = 0; i < count; ++i) {
+                    f(this->chunks_[chunk][i]);
+                }
+            }
+        }
+
+        void clear() {
+            this->arena_.release();
+            this->chunks_.clear();
+            this->size_ = 0;
+        }
+
+        size_t bytesReserved() const {
+            return this->arena_.bytesReserved();
+        }
+};
+
+// Traded volume of one symbol on one day. Only orders that were applied count, a rejected sell traded nothing.
+struct DailyVolume {
+    Date date;
+    Quantity bought;
+    Quantity sold;
+    Money notional; // sum of price * quantity over the day's fills
+};
+
+// Index over an OrderJournal for the end-of-day reports: per symbol, its orders sorted by date, and one
+// DailyVolume per day it traded. "Orders of X between two dates" is two binary searches over the symbol's
+// entries plus the k matches, instead of a scan over every order ever placed.
+//
+// The index is brought up to date lazily, by the first query after new orders came in, not on every order.
+// Adding to it per order would touch a different symbol's vectors each time, a few cache misses per order that
+// would triple the cost of addOrder. Catching up on a whole batch at once first sorts the new orders by symbol
+// (a counting sort, so each symbol keeps arrival order) and then appends every symbol's run in one go.
+// Orders normally arrive in date order and are simply appended; a backdated one is inserted at its place.
+// Journal positions are stored as uint32_t, which is enough for 4 billion orders.
+class OrderHistoryIndex {
+    public:
+        struct Entry {
+            Date date;
+            uint32_t order; // position in the journal
+        };
+
+    private:
+        struct SymbolHistory {
+            std::vector<Entry> entries;     // sorted by date, oldest first
+            std::vector<DailyVolume> daily; // sorted by date, only days with fills
+        };
+
+        // The day a symbol is currently trading on, added up before it goes into daily.
+        struct OpenDay {
+            bool open = false;
+            DailyVolume volume;
+        };
+
+        std::vector<SymbolHistory> symbols_; // indexed by SymbolId, the ids are dense
+        size_t indexed_ = 0;                 // journal orders [0, indexed_) are in the index
+        std::vector<uint32_t> rejected_;     // journal positions of rejected orders not indexed yet, ascending
+
+        std::vector<OpenDay> openDays_;      // indexed by SymbolId, only used inside catchUp
+
+        static bool dayBefore(const DailyVolume &volume, Date date) {
+            return volume.date < date;
+        }
+
+        static bool dateBeforeDay(Date date, const DailyVolume &volume) {
+            return date < volume.date;
+        }
+
+        static bool entryBefore(const Entry &entry, Date date) {
+            return entry.date < date;
+        }
+
+        static bool dateBeforeEntry(Date date, const Entry &entry) {
+            return date < entry.date;
+        }
+
+        static void addEntries(SymbolHistory &history, const Entry *begin, const Entry *end) {
+            history.entries.reserve(history.entries.size() + (end - begin));
+            for (const Entry *entry = begin; entry != end; ++entry) {
+                if (history.entries.empty() || history.entries.back().date <= entry->date) {
+                    history.entries.push_back(*entry);
+                } else {
+                    // after the orders already there for the same date, so they stay in arrival order
+                    history.entries.insert(std::upper_bound(history.entries.begin(), history.entries.end(), entry->date, dateBeforeEntry), *entry);
+                }
+            }
+        }
+
+        static void addVolume(SymbolHistory &history, const DailyVolume &volume) {
+            auto day = history.daily.end();
+            if (history.daily.empty() || history.daily.back().date < volume.date) {
+                history.daily.push_back(volume);
+                return;
+            } else if (history.daily.back().date == volume.date) {
+                day = history.daily.end() - 1;
+            } else {
+                day = std::lower_bound(history.daily.begin(), history.daily.end(), volume.date, dayBefore);
+                if (day->date != volume.date) {
+                    history.daily.insert(day, volume);
+                    return;
+                }
+            }
+            day->bought += volume.bought;
+            day->sold += volume.sold;
+            day->notional += volume.notional;
+        }
+
+    public:
+        // The order at journalPosition did not fill, so it does not count towards the daily volume.
+        void markRejected(uint32_t journalPosition) {
+            this->rejected_.push_back(journalPosition);
+        }
+
+        // Indexes the orders appended to journal since the last call.
+        void catchUp(const OrderJournal &journal) {
+            size_t end = journal.size();
+            if (this->indexed_ == end) {
+                return;
+            }
+            size_t symbolCount = globalSymbols().size();
+            if (this->symbols_.size() < symbolCount) {
+                this->symbols_.resize(symbolCount);
+                this->openDays_.resize(symbolCount);
+            }
+
+            // counting sort of the new orders by symbol, so every symbol's orders end up next to each other
+            // in arrival order. The journal is only read front to back, the random accesses go to counts
+            // and openDays_, which are small enough to stay in cache. sorted is as big as the batch,
+            // so it is a local that is freed again rather than a member kept around.
+            std::vector<uint32_t> counts(symbolCount + 1, 0);
+            for (size_t i = this->indexed_; i < end; ++i) {
+                counts[journal[i].symbol + 1]++;
+            }
+            for (size_t symbol = 1; symbol <= symbolCount; ++symbol) {
+                counts[symbol] += counts[symbol - 1];
+            }
+            std::vector<Entry> sorted(end - this->indexed_);
+            // the journal only grows, so rejected_ is ascending; catchUp erases what it consumed, so it starts at indexed_
+            auto rejected = std::lower_bound(this->rejected_.begin(), this->rejected_.end(), static_cast<uint32_t>(this->indexed_));
+            for (size_t i = this->indexed_; i < end; ++i) {
+                const Order &order = journal[i];
+                sorted[counts[order.symbol]++] = {order.date, static_cast<uint32_t>(i)};
+
+                if (rejected != this->rejected_.end() && *rejected == i) {
+                    ++rejected;
+                    continue;
+                }
+                OpenDay &day = this->openDays_[order.symbol];
+                if (day.open && day.volume.date != order.date) {
+                    addVolume(this->symbols_[order.symbol], day.volume);
+                    day.open = false;
+                }
+                if (!day.open) {
+                    day = {true, {order.date, Quantity(), Quantity(), Money()}};
+                }
+                (order.type == OrderType::BUY ? day.volume.bought : day.volume.sold) += order.quantity;
+                day.volume.notional += order.price * order.quantity;
+            }
+
+            // counts[symbol] is now where the symbol's run ends and the next one's starts
+            for (size_t symbol = 0; symbol < symbolCount; ++symbol) {
+                uint32_t begin = symbol == 0 ? 0 : counts[symbol - 1];
+                if (begin != counts[symbol]) {
+                    addEntries(this->symbols_[symbol], sorted.data() + begin, sorted.data() + counts[symbol]);
+                }
+                if (this->openDays_[symbol].open) {
+                    addVolume(this->symbols_[symbol], this->openDays_[symbol].volume);
+                    this->openDays_[symbol].open = false;
+                }
+            }
+            // rejections of orders now indexed are never looked at again
+            this->rejected_.erase(this->rejected_.begin(), rejected);
+            this->indexed_ = end;
+        }
+
+        // symbol's orders dated from..to (both included), oldest first. Call catchUp first.
+        std::span<const Entry> ordersBetween(SymbolId symbol, Date from, Date to) const {
+            if (symbol >= this->symbols_.size()) {
+                return {};
+            }
+            const std::vector<Entry> &entries = this->symbols_[symbol].entries;
+            auto begin = std::lower_bound(entries.begin(), entries.end(), from, entryBefore);
+            auto end = std::upper_bound(begin, entries.end(), to, dateBeforeEntry);
+            return std::span<const Entry>(begin, end);
+        }
+
+        // Days from..to (both included) on which symbol traded. Call catchUp first.
+        std::span<const DailyVolume> dailyVolume(SymbolId symbol, Date from, Date to) const {
+            if (symbol >= this->symbols_.size()) {
+                return {};
+            }
+            const std::vector<DailyVolume> &daily = this->symbols_[symbol].daily;
+            auto begin = std::lower_bound(daily.begin(), daily.end(), from, dayBefore);
+            auto end = std::upper_bound(begin, daily.end(), to, dateBeforeDay);
+            return std::span<const DailyVolume>(begin, end);
+        }
+
+        void clear() {
+            this->symbols_.clear();
+            this->openDays_.clear();
+            this->rejected_.clear();
+            this->indexed_ = 0;
+        }
+
+        size_t bytesReserved() const {
+            size_t bytes = this->symbols_.capacity() * sizeof(SymbolHistory) + this->rejected_.capacity() * sizeof(uint32_t);
+            for (const SymbolHistory &history : this->symbols_) {
+                bytes += history.entries.capacity() * sizeof(Entry) + history.daily.capacity() * sizeof(DailyVolume);
+            }
+            return bytes;
+        }
+};
+
 class Portfolio {
     public:
         void addOrder(const Order &order) {
-            // add order to the back of orders vector
-            orders.push_back(order);
+            // add order to the back of the order history
+            uint32_t journalPosition = static_cast<uint32_t>(orders.size());
+            orders.append(order);
 
             if (order.type == OrderType::BUY) {
-                addPosition({order.ticker, order.price, order.quantity});
+                addPosition({order.symbol, order.price, order.quantity, order.price, Money()});
                 return;
             } else if (order.type == OrderType::SELL) {
-                removePosition(order.ticker, order.quantity);
+                if (!removePosition(order.symbol, order.quantity, order.price)) {
+                    history.markRejected(journalPosition);
+                }
+                return;
+            }
+        }
+
+        // Same result as calling addOrder for each order in turn, including the error messages and their order,
+        // but each symbol's position is looked up once per batch instead of once per order, the totals are
+        // updated once per symbol, and positions that ended up empty are removed in one compaction at the end.
+        void applyOrders(std::span<const Order> batch) {
+            // setting up costs more than it saves for a handful of orders
+            if (batch.size() < 16) {
+                for (const Order &order : batch) {
+                    addOrder(order);
+                }
                 return;
             }
+
+            // SymbolIds are dense, so symbol -> working position is a plain array instead of a hash lookup;
+            // a stamp per entry tells which batch wrote it, so the array never needs clearing
+            batchNumber++;
+            batchWork.clear();
+            for (const Order &order : batch) {
+                uint32_t journalPosition = static_cast<uint32_t>(orders.size());
+                orders.append(order);
+                if (order.symbol >= batchSymbolWork.size()) {
+                    batchSymbolWork.resize(order.symbol + 1, {0, 0});
+                }
+                SymbolWork &entry = batchSymbolWork[order.symbol];
+                if (entry.batch != batchNumber) {
+                    entry = {batchNumber, static_cast<uint32_t>(batchWork.size())};
+                    batchWork.push_back(openWork(order.symbol));
+                }
+                if (!applyToWork(batchWork[entry.work], order)) {
+                    history.markRejected(journalPosition);
+                }
+            }
+
+            batchEmptied.clear();
+            for (const WorkingPosition &work : batchWork) {
+                closeWork(work);
+            }
+            // highest index first, so a position moved into a freed slot by erasePosition is never one
+            // that is still waiting to be erased
+            std::sort(batchEmptied.begin(), batchEmptied.end(), std::greater<uint32_t>());
+            for (uint32_t index : batchEmptied) {
+                erasePosition(index);
+            }
         }
 
         void printPositions() {
@@ -53,8 +722,8 @@ class Portfolio {
                 // we want exactly what is in positions vector
                 // const so we don't modify it
                 for (const Position &pos : positions) {
-                    if (pos.quantity > 0) {
-                        std::cout << "Ticker: " << pos.ticker 
+                    if (pos.quantity > Quantity()) {
+                        std::cout << "Ticker: " << globalSymbols().name(pos.symbol) 
                                 << ", Avg Price: " << pos.avgPrice 
                                 << ", Quantity: " << pos.quantity << std::endl;
                     }
@@ -71,103 +740,2091 @@ class Portfolio {
             else {
                 std::cout << "Order History:" << std::endl;
                 for (const Order &order : orders) {
-                    std::cout << "Ticker: " << order.ticker 
-                            << ", Price: " << order.price 
-                            << ", Quantity: " << order.quantity 
-                            << ", Type: " << (order.type == OrderType::BUY ? "BUY" : "SELL")
-                            << ", Date: " << order.date.day << "/" << order.date.month << "/" << order.date.year
-                            << std::endl;
+                    printOrder(order);
                 }
                 return;
             }
         }
 
-        double getTotalValue() {
-            double totalValue = 0.0;
-            for (const Position &pos : positions) {
-                totalValue += pos.avgPrice * pos.quantity;
+        // Only symbol's orders dated from..to, found through the history index.
+        void printOrders(SymbolId symbol, Date from, Date to) {
+            history.catchUp(orders);
+            std::span<const OrderHistoryIndex::Entry> found = history.ordersBetween(symbol, from, to);
+            if (found.empty()) {
+                std::cout << "No orders for " << globalSymbols().name(symbol) << " in that period." << std::endl;
+                return;
+            }
+            std::cout << "Order History for " << globalSymbols().name(symbol) << ":" << std::endl;
+            for (const OrderHistoryIndex::Entry &entry : found) {
+                printOrder(orders[entry.order]);
+            }
+        }
+
+        // Calls f(const Order&) for each of symbol's orders dated from..to (both included), oldest first.
+        // O(log n + k) for n orders of that symbol and k matches, once the index has caught up with new orders.
+        template <typename F>
+        void forEachOrder(SymbolId symbol, Date from, Date to, F&& f) {
+            history.catchUp(orders);
+            for (const OrderHistoryIndex::Entry &entry : history.ordersBetween(symbol, from, to)) {
+                f(orders[entry.order]);
+            }
+        }
+
+        // Volume per day for symbol between from and to (both included), days without fills are left out.
+        // The span is valid until the next order is added.
+        std::span<const DailyVolume> getDailyVolume(SymbolId symbol, Date from, Date to) {
+            history.catchUp(orders);
+            return history.dailyVolume(symbol, from, to);
+        }
+
+        // Marks a held symbol to a new market price. O(1): only the difference goes into the running market value.
+        // Ticks for symbols that are not held are ignored.
+        void updatePrice(SymbolId symbol, Price price) {
+            if (uint32_t* index = positionIndex.find(symbol)) {
+                Position &pos = positions[*index];
+                marketValue += (price - pos.markPrice) * pos.quantity;
+                pos.markPrice = price;
             }
-            return totalValue;
         }
 
+        void updatePrice(const PriceTick &tick) {
+            updatePrice(tick.symbol, tick.price);
+        }
+
+        // The totals below are kept up to date by every fill and tick, so reading them is O(1).
+
+        // What was paid for the positions still held (cost basis).
+        Money getTotalValue() const {
+            return costBasis;
+        }
+
+        // What the positions are worth at the latest mark prices.
+        Money getMarketValue() const {
+            return marketValue;
+        }
+
+        Money getUnrealizedPnl() const {
+            return marketValue - costBasis;
+        }
+
+        // Profit of every sell so far, including positions that are closed by now.
+        Money getRealizedPnl() const {
+            return realizedPnl;
+        }
+
+        // Unrealized profit of one position, 0 if it is not held.
+        Money getUnrealizedPnl(SymbolId symbol) const {
+            const uint32_t* index = positionIndex.find(symbol);
+            if (index == nullptr) {
+                return Money();
+            }
+            const Position &pos = positions[*index];
+            return (pos.markPrice - pos.avgPrice) * pos.quantity;
+        }
 
         void clearPositions() {
             positions.clear();
+            positionIndex.clear();
+            costBasis = Money();
+            marketValue = Money();
             return;
         }
 
         void clearOrders() {
             orders.clear();
+            history.clear();
             return;
         }
 
+        const std::vector<Position>& getPositions() const {
+            return positions;
+        }
+
+        // Replaces all positions and the realized profit total (which also counts closed positions), used when loading a saved state.
+        void restorePositions(const std::vector<Position> &saved, Money realized) {
+            clearPositions();
+            realizedPnl = realized;
+            for (const Position &pos : saved) {
+                positionIndex.insert(pos.symbol, static_cast<uint32_t>(positions.size()));
+                positions.push_back(pos);
+                costBasis += pos.avgPrice * pos.quantity;
+                marketValue += pos.markPrice * pos.quantity;
+            }
+        }
+
+        size_t historyIndexBytes() const {
+            return history.bytesReserved();
+        }
+
+        // Read-only access to every order so far, for reports.
+        const OrderJournal& orderHistory() const {
+            return orders;
+        }
+
     private:
         // Internal storage for positions and orders
         // Vectors can dynamically resize
+        // positions holds no zero quantity entries, positionIndex maps a symbol to its index in positions
         std::vector<Position> positions;
-        std::vector<Order> orders;
+        OrderJournal orders;
+        OrderHistoryIndex history; // by symbol and date, over orders
+        FlatHashMap<SymbolId, uint32_t> positionIndex;
+        // running totals over positions, see getTotalValue() and friends; integer sums, so they never drift
+        Money costBasis;
+        Money marketValue;
+        Money realizedPnl;
 
         void addPosition(const Position &pos) {
-            for (Position &existingPos : positions) {
-                if (existingPos.ticker == pos.ticker) {
-                    existingPos.avgPrice = (existingPos.avgPrice * existingPos.quantity + pos.avgPrice * pos.quantity) / (existingPos.quantity + pos.quantity); // Update average price
-                    existingPos.quantity += pos.quantity; // Update quantity
-                    return;
-                }
+            // one hash lookup instead of comparing the ticker with every position
+            if (uint32_t* index = positionIndex.find(pos.symbol)) {
+                Position &existingPos = positions[*index];
+                Money oldCost = existingPos.avgPrice * existingPos.quantity;
+                Money oldMarket = existingPos.markPrice * existingPos.quantity;
+                Quantity newQuantity = existingPos.quantity + pos.quantity;
+                existingPos.avgPrice = averagePrice(oldCost + pos.avgPrice * pos.quantity, newQuantity); // Update average price
+                existingPos.quantity = newQuantity; // Update quantity
+                // the average is rounded, so the cost basis changes by new minus old rather than by the fill's cost
+                costBasis += existingPos.avgPrice * existingPos.quantity - oldCost;
+                // a fill is a trade at a market price, newer than the old mark: the whole position is marked to it
+                existingPos.markPrice = pos.markPrice;
+                marketValue += existingPos.markPrice * existingPos.quantity - oldMarket;
+                return;
             }
+            costBasis += pos.avgPrice * pos.quantity;
+            marketValue += pos.markPrice * pos.quantity;
+            positionIndex.insert(pos.symbol, static_cast<uint32_t>(positions.size()));
             positions.push_back(pos); // Add new position if not found
             return;
         }
 
-        void removePosition(const std::string &ticker, double quantity) {
-            for (Position &existingPos : positions) {
-                if (existingPos.ticker == ticker) {
-                    if (existingPos.quantity < quantity) {
-                        std::cout << "Error: Not enough quantity to sell for " << ticker << std::endl;
-                        return;
-                    }
-                    existingPos.quantity -= quantity; // Update quantity
-                    // no problem if quantity becomes zero, we will clean it up later
+        // false if the sell was rejected
+        bool removePosition(SymbolId symbol, Quantity quantity, Price price) {
+            uint32_t* index = positionIndex.find(symbol);
+            if (index == nullptr) {
+                printSellError(SellError::NoPosition, symbol);
+                return false;
+            }
+            Position &existingPos = positions[*index];
+            if (existingPos.quantity < quantity) {
+                printSellError(SellError::NotEnoughQuantity, symbol);
+                return false;
+            }
+            Money oldMarket = existingPos.markPrice * existingPos.quantity;
+            existingPos.quantity -= quantity; // Update quantity
+            costBasis -= existingPos.avgPrice * quantity;
+            existingPos.markPrice = price; // what is left is marked to the fill, like a buy
+            marketValue += existingPos.markPrice * existingPos.quantity - oldMarket;
+            Money profit = (price - existingPos.avgPrice) * quantity;
+            existingPos.realizedPnl += profit;
+            realizedPnl += profit;
 
-                    removeZeroQuantityPositions(); // Clean up zero quantity positions
-                    return;
+            if (existingPos.quantity == Quantity()) { // exact, no leftover 1e-13 shares
+                erasePosition(*index); // only the emptied position goes, no pass over the others
+            }
+            return true;
+        }
+
+        static void printOrder(const Order &order) {
+            std::cout << "Ticker: " << globalSymbols().name(order.symbol) 
+                    << ", Price: " << order.price 
+                    << ", Quantity: " << order.quantity 
+                    << ", Type: " << (order.type == OrderType::BUY ? "BUY" : "SELL")
+                    << ", Date: " << order.date.day() << "/" << order.date.month() << "/" << order.date.year()
+                    << std::endl;
+        }
+
+        enum class SellError {
+            NoPosition,
+            NotEnoughQuantity
+        };
+
+        static void printSellError(SellError kind, SymbolId symbol) {
+            if (kind == SellError::NoPosition) {
+                std::cout << "Error: No position found for ticker " << globalSymbols().name(symbol) << std::endl;
+            } else {
+                std::cout << "Error: Not enough quantity to sell for " << globalSymbols().name(symbol) << std::endl;
+            }
+        }
+
+        // A symbol's position while a batch is applied. The orders change positions[index] in place; a symbol
+        // that is not held yet gets an empty slot first, and slots that are empty at the end are erased then.
+        // The totals only change by the position's value at the end minus its value at the start: cost and
+        // market value are exact integer products, so that equals the sum of the per-order changes
+        // addPosition and removePosition would have made.
+        struct WorkingPosition {
+            uint32_t index;
+            bool open; // holds shares right now
+            Money costBefore;
+            Money marketBefore;
+        };
+
+        // scratch space of applyOrders, kept between batches so a steady stream of batches does not allocate
+        struct SymbolWork {
+            uint64_t batch; // batchNumber when work was assigned
+            uint32_t work;  // index in batchWork
+        };
+        // 64 bits so it never wraps: after 2^32 batches a 32-bit number would match entries left by an old batch
+        uint64_t batchNumber = 0;
+        std::vector<SymbolWork> batchSymbolWork; // indexed by SymbolId
+        std::vector<WorkingPosition> batchWork;
+        std::vector<uint32_t> batchEmptied;      // positions to erase at the end of the batch
+
+        WorkingPosition openWork(SymbolId symbol) {
+            if (uint32_t* index = positionIndex.find(symbol)) {
+                const Position &pos = positions[*index];
+                return {*index, true, pos.avgPrice * pos.quantity, pos.markPrice * pos.quantity};
+            }
+            uint32_t index = static_cast<uint32_t>(positions.size());
+            positionIndex.insert(symbol, index);
+            positions.push_back({symbol, Price(), Quantity(), Price(), Money()});
+            return {index, false, Money(), Money()};
+        }
+
+        // the same rules as addPosition and removePosition; false if the order was rejected
+        bool applyToWork(WorkingPosition &work, const Order &order) {
+            Position &pos = positions[work.index];
+            if (order.type == OrderType::BUY) {
+                if (work.open) {
+                    Quantity newQuantity = pos.quantity + order.quantity;
+                    pos.avgPrice = averagePrice(pos.avgPrice * pos.quantity + order.price * order.quantity, newQuantity);
+                    pos.quantity = newQuantity;
+                    pos.markPrice = order.price;
+                } else {
+                    pos = {order.symbol, order.price, order.quantity, order.price, Money()};
+                    work.open = true;
                 }
+            } else if (!work.open) {
+                printSellError(SellError::NoPosition, order.symbol);
+                return false;
+            } else if (pos.quantity < order.quantity) {
+                printSellError(SellError::NotEnoughQuantity, order.symbol);
+                return false;
+            } else {
+                pos.quantity -= order.quantity;
+                pos.markPrice = order.price;
+                Money profit = (order.price - pos.avgPrice) * order.quantity;
+                pos.realizedPnl += profit;
+                realizedPnl += profit;
+                work.open = pos.quantity != Quantity();
+            }
+            return true;
+        }
+
+        void closeWork(const WorkingPosition &work) {
+            if (work.open) {
+                const Position &pos = positions[work.index];
+                costBasis += pos.avgPrice * pos.quantity;
+                marketValue += pos.markPrice * pos.quantity;
+            } else {
+                batchEmptied.push_back(work.index);
             }
-            std::cout << "Error: No position found for ticker " << ticker << std::endl;
+            costBasis -= work.costBefore;
+            marketValue -= work.marketBefore;
         }
 
-        void removeZeroQuantityPositions() {
-            // erase(start iterator, end iterator), erase is left inclusive, right exclusive [left, right)
-            // vect.begin() returns iterator to the first element
-            // vect.end() returns iterator to one past the last element
-            // remove_if(start iterator, end iterator, condition) -> iterator to the logical end of the range
-            // remove_if shifts all elements that do not meet the condition to the front of the range, keeps the ones that meet the condition at the end
-            // keeps relative order of elements that do not meet the condition
-            // returns iterator to the new logical end of the range (first element to be removed)
-            // lambda function: [capture](parameters) -> return_type { body }
-            // We capture nothing, take a Position reference, return bool for every position that meets the condition
-            // The erase() then sees only a range starting from the first element to be removed to the actual end of the vector (one after) and removes that range
-            positions.erase(std::remove_if(positions.begin(), positions.end(), 
-                [](const Position &pos) { return pos.quantity == 0; }),
-                positions.end());
+        // Removes positions[index] in O(1): the last position is moved into its slot and the vector shrinks by one.
+        // Unlike erase() this does not keep the order of the positions, which nothing relies on.
+        void erasePosition(uint32_t index) {
+            positionIndex.erase(positions[index].symbol);
+            if (index + 1 != positions.size()) {
+                positions[index] = positions.back();
+                positionIndex.insert(positions[index].symbol, index);
+            }
+            positions.pop_back();
         }
 };
 
-int main() {
+// --- Persistence ---
+// Portfolio lives in memory only. PersistentPortfolio adds a write-ahead journal: every order is appended to a
+// file before it is applied, so after a crash or restart the positions can be rebuilt by replaying the file.
+// Replaying years of orders would get slow, so every now and then the positions are also written to a snapshot
+// file together with the journal offset they correspond to, and recovery only replays what came after it.
+//
+// Journal file: a sequence of records, each a WalRecordHeader followed by its payload.
+//   kind 1, symbol: a WalSymbolRecord followed by the ticker's characters. Symbol ids are only meaningful
+//                   inside one process, so the journal numbers symbols itself and defines each one before first use.
+//   kind 2, order:  a WalOrderRecord.
+// A crash can leave a half written record at the end. Its checksum (or length) will not match,
+// recovery stops there and cuts the file back to the last complete record.
+//
+// Snapshot file: SnapshotHeader, the journal's symbol dictionary, the positions, then a CRC32 of everything before it.
+// It is written to a temporary file and renamed over the old one, so a crash mid-write leaves the previous snapshot intact.
+// Both files use this machine's native byte order.
 
-    Portfolio myPortfolio;
+// Standard CRC-32 (the one zip and PNG use), table driven, one byte per step.
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
 
-    myPortfolio.addOrder({"AAPL", 150.0, 10, OrderType::BUY, {1, 1, 2025}});
-    myPortfolio.addOrder({"AAPL", 160.0, 10, OrderType::BUY, {2, 1, 2025}});
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
 
-    myPortfolio.printPositions();
+enum class WalRecordKind : uint32_t {
+    Symbol = 1,
+    Order = 2
+};
 
-    myPortfolio.addOrder({"AAPL", 155.0, 20, OrderType::SELL, {3, 1, 2025}});
-    myPortfolio.addOrder({"GOOGL", 2800.0, 5, OrderType::BUY, {4, 1, 2025}});
+struct WalRecordHeader {
+    WalRecordKind kind;
+    uint32_t length; // payload bytes
+    uint32_t crc;    // CRC32 of the payload
+};
+
+struct WalSymbolRecord {
+    uint32_t journalSymbol;
+    uint32_t nameLength;
+};
+
+struct WalOrderRecord {
+    uint64_t sequence; // 1, 2, 3, ... in journal order
+    uint32_t journalSymbol;
+    OrderType type;
+    Price price;       // stored as the raw fixed-point count, the scales are part of the format
+    Quantity quantity;
+    Date date;
+};
+
+// When appended orders are forced from the OS cache onto the disk.
+// Orders are first collected in the process (the batch) and only reach the OS when the batch is written: when it is full,
+// when its oldest order is maxBatchDelay old, or on commit(). A process crash loses whatever is still in the batch;
+// a written batch survives a process crash even without fsync (the OS has it), but a power cut can lose unsynced batches.
+// So only commit() makes an order crash-safe at a known point; without it an order is safe at most maxBatchDelay after
+// it was added, as long as more orders keep coming (the delay is checked when the next order arrives, there is no timer).
+enum class FsyncPolicy {
+    Never,      // leave it to the OS
+    EveryBatch, // after every group commit, safest and slowest
+    Interval    // at most once per fsyncInterval
+};
+
+struct PersistenceOptions {
+    size_t batchBytes = 64 * 1024; // group commit: orders are buffered and written with one write() per batch
+    FsyncPolicy fsyncPolicy = FsyncPolicy::Interval;
+    std::chrono::milliseconds fsyncInterval{100};
+    std::chrono::milliseconds maxBatchDelay{10}; // a batch is written once its oldest order is this old, even if not full
+    size_t snapshotEvery = 1'000'000; // orders between position snapshots, 0 disables them
+};
+
+// Thin RAII wrapper over an OS file descriptor, opened for appending.
+class AppendFile {
+    private:
+        int fd_ = -1;
+
+    public:
+        explicit AppendFile(const std::string& path, bool truncate = false) {
+#if defined(_WIN32)
+            this->fd_ = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+#else
+            this->fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+#endif
+            if (this->fd_ < 0) {
+                throw std::runtime_error("Error opening file: " + path);
+            }
+        }
+
+        AppendFile(const AppendFile&) = delete;
+        AppendFile& operator=(const AppendFile&) = delete;
+
+        ~AppendFile() {
+            if (this->fd_ >= 0) {
+#if defined(_WIN32)
+                _close(this->fd_);
+#else
+                ::close(this->fd_);
+#endif
+            }
+        }
+
+        void write(const char* data, size_t size) {
+            while (size > 0) {
+#if defined(_WIN32)
+                int written = _write(this->fd_, data, static_cast<unsigned>(std::min<size_t>(size, 1 << 30)));
+#else
+                ssize_t written = ::write(this->fd_, data, size);
+#endif
+                if (written < 0) {
+                    throw std::runtime_error("Error writing file");
+                }
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+        }
+
+        // Returns once the data written so far is on the disk, not just in the OS cache.
+        void sync() {
+#if defined(_WIN32)
+            int result = _commit(this->fd_);
+#else
+            int result = ::fsync(this->fd_);
+#endif
+            if (result != 0) {
+                throw std::runtime_error("Error syncing file");
+            }
+        }
+};
+
+// A Portfolio whose orders survive restarts. All state lives in directory: orders.wal and positions.snapshot.
+class PersistentPortfolio {
+    public:
+        struct RecoveryStats {
+            uint64_t snapshotSequence = 0; // orders covered by the snapshot
+            uint64_t replayedOrders = 0;   // orders replayed from the journal tail
+            uint64_t truncatedBytes = 0;   // torn record bytes cut off the end of the journal
+            double seconds = 0.0;
+        };
+
+    private:
+        struct SnapshotHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t symbolCount;
+            uint64_t sequence;      // last order included
+            uint64_t journalOffset; // where replay continues
+            uint64_t positionCount;
+            Money realizedPnl;      // portfolio total, including positions closed since
+        };
+
+        struct SnapshotPosition {
+            uint32_t journalSymbol;
+            Price avgPrice;
+            Quantity quantity;
+            Price markPrice;
+            Money realizedPnl;
+        };
+
+        // version 3: marks and realized profit are saved, so a restore matches a full replay
+        static constexpr uint32_t snapshotVersion = 3;
+
+        // version 2: prices and quantities are fixed-point, version 3: dates are a day number
+        // (older journals are not readable)
+        static constexpr char walMagic[8] = {'O', 'R', 'D', 'W', 'A', 'L', '0', '3'};
+        static constexpr char snapshotMagic[8] = {'P', 'O', 'S', 'N', 'A', 'P', 'S', '1'};
+
+        std::filesystem::path directory_;
+        PersistenceOptions options_;
+        Portfolio portfolio_;
+        std::unique_ptr<AppendFile> wal_;
+        std::vector<char> batch_;
+        uint64_t journalSize_ = 0; // bytes in the file plus bytes in batch_
+        uint64_t sequence_ = 0;
+        uint64_t ordersSinceSnapshot_ = 0;
+        std::chrono::steady_clock::time_point lastSync_;
+        std::chrono::steady_clock::time_point batchStart_; // when the first record of the current batch was added
+        RecoveryStats recovery_;
+
+        // journal symbol numbering, in both directions
+        std::vector<SymbolId> journalToGlobal_;
+        FlatHashMap<SymbolId, uint32_t> globalToJournal_;
+
+        std::filesystem::path walPath() const { return this->directory_ / "orders.wal"; }
+        std::filesystem::path snapshotPath() const { return this->directory_ / "positions.snapshot"; }
+
+        void appendRecord(WalRecordKind kind, const void* payload, uint32_t length) {
+            WalRecordHeader header = {kind, length, crc32(payload, length)};
+            if (this->batch_.empty()) {
+                this->batchStart_ = std::chrono::steady_clock::now();
+            }
+            const char* headerBytes = reinterpret_cast<const char*>(&header);
+            const char* payloadBytes = static_cast<const char*>(payload);
+            this->batch_.insert(this->batch_.end(), headerBytes, headerBytes + sizeof(header));
+            this->batch_.insert(this->batch_.end(), payloadBytes, payloadBytes + length);
+            this->journalSize_ += sizeof(header) + length;
+        }
+
+        uint32_t journalSymbolFor(SymbolId symbol) {
+            if (uint32_t* known = this->globalToJournal_.find(symbol)) {
+                return *known;
+            }
+            uint32_t journalSymbol = static_cast<uint32_t>(this->journalToGlobal_.size());
+            this->journalToGlobal_.push_back(symbol);
+            this->globalToJournal_.insert(symbol, journalSymbol);
+
+            std::string_view name = globalSymbols().name(symbol);
+            WalSymbolRecord record = {journalSymbol, static_cast<uint32_t>(name.size())};
+            std::vector<char> payload(reinterpret_cast<const char*>(&record), reinterpret_cast<const char*>(&record) + sizeof(record));
+            payload.insert(payload.end(), name.begin(), name.end());
+            this->appendRecord(WalRecordKind::Symbol, payload.data(), static_cast<uint32_t>(payload.size()));
+            return journalSymbol;
+        }
+
+        void defineJournalSymbol(uint32_t journalSymbol, std::string_view name) {
+            if (journalSymbol != this->journalToGlobal_.size()) {
+                throw std::runtime_error("Corrupt order journal: symbols out of order");
+            }
+            SymbolId symbol = globalSymbols().intern(name);
+            this->journalToGlobal_.push_back(symbol);
+            this->globalToJournal_.insert(symbol, journalSymbol);
+        }
+
+        // Loads the snapshot if there is a valid one. Returns the journal offset to replay from.
+        uint64_t loadSnapshot() {
+            std::ifstream file(this->snapshotPath(), std::ios::binary);
+            if (!file.is_open()) {
+                return 0;
+            }
+            std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            SnapshotHeader header;
+            uint32_t storedCrc;
+            if (bytes.size() < sizeof(header) + sizeof(storedCrc)) {
+                throw std::runtime_error("Corrupt position snapshot: file too small");
+            }
+            std::memcpy(&storedCrc, bytes.data() + bytes.size() - sizeof(storedCrc), sizeof(storedCrc));
+            if (crc32(bytes.data(), bytes.size() - sizeof(storedCrc)) != storedCrc) {
+                throw std::runtime_error("Corrupt position snapshot: checksum mismatch");
+            }
+            std::memcpy(&header, bytes.data(), sizeof(header));
+            if (std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0 || header.version != snapshotVersion) {
+                throw std::runtime_error("Not a position snapshot: " + this->snapshotPath().string());
+            }
+
+            size_t offset = sizeof(header);
+            for (uint32_t i = 0; i < header.symbolCount; ++i) {
+                uint32_t length;
+                std::memcpy(&length, bytes.data() + offset, sizeof(length));
+                offset += sizeof(length);
+                this->defineJournalSymbol(i, std::string_view(bytes.data() + offset, length));
+                offset += length;
+            }
+            std::vector<Position> positions;
+            for (uint64_t i = 0; i < header.positionCount; ++i) {
+                SnapshotPosition stored;
+                std::memcpy(&stored, bytes.data() + offset, sizeof(stored));
+                offset += sizeof(stored);
+                positions.push_back({this->journalToGlobal_.at(stored.journalSymbol), stored.avgPrice, stored.quantity, stored.markPrice, stored.realizedPnl});
+            }
+            this->portfolio_.restorePositions(positions, header.realizedPnl);
+            this->sequence_ = header.sequence;
+            this->recovery_.snapshotSequence = header.sequence;
+            return header.journalOffset;
+        }
+
+        // Replays the journal from offset and returns the length of its valid part.
+        uint64_t replayJournal(uint64_t offset) {
+            std::ifstream file(this->walPath(), std::ios::binary);
+            if (!file.is_open()) {
+                return 0;
+            }
+
+            char magic[sizeof(walMagic)];
+            if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, walMagic, sizeof(walMagic)) != 0) {
+                throw std::runtime_error("Not an order journal: " + this->walPath().string());
+            }
+            offset = std::max<uint64_t>(offset, sizeof(walMagic));
+            file.seekg(static_cast<std::streamoff>(offset));
+
+            // records are small, reading them through a big buffer keeps the number of read calls low
+            std::vector<char> buffer(1 << 20);
+            size_t begin = 0, end = 0;
+            uint64_t validEnd = offset;
+            // makes sure at least needed unread bytes are in the buffer, unless the file ends first
+            auto ensure = [&](size_t needed) {
+                if (end - begin >= needed) {
+                    return true;
+                }
+                std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+                file.read(buffer.data() + end, static_cast<std::streamsize>(buffer.size() - end));
+                end += static_cast<size_t>(file.gcount());
+                return end - begin >= needed;
+            };
+            while (true) {
+                WalRecordHeader header;
+                if (!ensure(sizeof(header))) break;
+                std::memcpy(&header, buffer.data() + begin, sizeof(header));
+                if (header.length > buffer.size() / 2 || !ensure(sizeof(header) + header.length)) break;
+                const char* payload = buffer.data() + begin + sizeof(header);
+                if (crc32(payload, header.length) != header.crc) break;
+
+                if (header.kind == WalRecordKind::Symbol && header.length >= sizeof(WalSymbolRecord)) {
+                    WalSymbolRecord record;
+                    std::memcpy(&record, payload, sizeof(record));
+                    if (record.nameLength != header.length - sizeof(record)) break;
+                    if (this->journalToGlobal_.size() <= record.journalSymbol) {
+                        this->defineJournalSymbol(record.journalSymbol, std::string_view(payload + sizeof(record), record.nameLength));
+                    }
+                } else if (header.kind == WalRecordKind::Order && header.length == sizeof(WalOrderRecord)) {
+                    WalOrderRecord record;
+                    std::memcpy(&record, payload, sizeof(record));
+                    this->portfolio_.addOrder({this->journalToGlobal_.at(record.journalSymbol), record.price, record.quantity, record.type, record.date});
+                    this->sequence_ = record.sequence;
+                    this->recovery_.replayedOrders++;
+                } else {
+                    break; // unknown record, treat like a torn write
+                }
+                begin += sizeof(header) + header.length;
+                validEnd += sizeof(header) + header.length;
+            }
+            return validEnd;
+        }
+
+        // Sends the batch to the OS and syncs according to the fsync policy.
+        void writeBatch(bool forceSync) {
+            if (!this->batch_.empty()) {
+                this->wal_->write(this->batch_.data(), this->batch_.size());
+                this->batch_.clear();
+            }
+            auto now = std::chrono::steady_clock::now();
+            bool sync = forceSync || this->options_.fsyncPolicy == FsyncPolicy::EveryBatch
+                || (this->options_.fsyncPolicy == FsyncPolicy::Interval && now - this->lastSync_ >= this->options_.fsyncInterval);
+            if (sync) {
+                this->wal_->sync();
+                this->lastSync_ = now;
+            }
+        }
+
+    public:
+        // Opens (or creates) the journal in directory and rebuilds the positions: snapshot first, then the journal tail.
+        explicit PersistentPortfolio(const std::string& directory, PersistenceOptions options = {})
+            : directory_(directory), options_(options), lastSync_(std::chrono::steady_clock::now()) {
+            auto start = std::chrono::steady_clock::now();
+            std::filesystem::create_directories(this->directory_);
+
+            uint64_t replayFrom = this->loadSnapshot();
+            bool exists = std::filesystem::exists(this->walPath());
+            if (replayFrom > 0 && (!exists || std::filesystem::file_size(this->walPath()) < replayFrom)) {
+                throw std::runtime_error("Order journal is missing or shorter than the position snapshot in " + directory);
+            }
+            // The file is created before its magic is written, so a crash right after creating it leaves it empty or
+            // with part of the magic. That is a journal nothing was ever recorded in: start it over instead of refusing
+            // to open the directory. Only a file with all 8 magic bytes present and wrong is "not an order journal".
+            bool fresh = !exists;
+            if (exists && replayFrom == 0 && std::filesystem::file_size(this->walPath()) < sizeof(walMagic)) {
+                this->recovery_.truncatedBytes = std::filesystem::file_size(this->walPath());
+                std::filesystem::resize_file(this->walPath(), 0);
+                fresh = true;
+            }
+            uint64_t validEnd = fresh ? 0 : this->replayJournal(replayFrom);
+            if (!fresh) {
+                uint64_t fileSize = std::filesystem::file_size(this->walPath());
+                if (validEnd < fileSize) {
+                    // drop the torn tail so new records follow the last complete one
+                    std::filesystem::resize_file(this->walPath(), validEnd);
+                    this->recovery_.truncatedBytes = fileSize - validEnd;
+                }
+            }
+
+            this->wal_ = std::make_unique<AppendFile>(this->walPath().string());
+            this->journalSize_ = validEnd;
+            if (fresh) {
+                this->batch_.insert(this->batch_.end(), walMagic, walMagic + sizeof(walMagic));
+                this->journalSize_ = sizeof(walMagic);
+                this->writeBatch(true);
+            }
+            this->batch_.reserve(this->options_.batchBytes + 256);
+            this->recovery_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        PersistentPortfolio(const PersistentPortfolio&) = delete;
+        PersistentPortfolio& operator=(const PersistentPortfolio&) = delete;
+
+        // Whatever is still buffered goes to disk on a clean shutdown.
+        ~PersistentPortfolio() {
+            try {
+                this->writeBatch(true);
+            } catch (std::exception &e) {
+                std::cerr << "Exception occurred: " << e.what() << std::endl;
+            }
+        }
+
+        // Journals the order, then applies it. The order survives a process crash once its batch has been written:
+        // when the batch is full or maxBatchDelay old (checked here), or at commit(), which also syncs it.
+        void addOrder(const Order &order) {
+            uint32_t journalSymbol = this->journalSymbolFor(order.symbol);
+            WalOrderRecord record = {++this->sequence_, journalSymbol, order.type, order.price, order.quantity, order.date};
+            this->appendRecord(WalRecordKind::Order, &record, sizeof(record));
+            if (this->batch_.size() >= this->options_.batchBytes
+                || std::chrono::steady_clock::now() - this->batchStart_ >= this->options_.maxBatchDelay) {
+                this->writeBatch(false);
+            }
+
+            this->portfolio_.addOrder(order);
+
+            if (this->options_.snapshotEvery > 0 && ++this->ordersSinceSnapshot_ >= this->options_.snapshotEvery) {
+                this->writeSnapshot();
+            }
+        }
+
+        // Writes the current batch now instead of waiting for it to fill up, and syncs it.
+        void commit() {
+            this->writeBatch(true);
+        }
+
+        // Saves the positions and the journal offset they correspond to.
+        void writeSnapshot() {
+            this->writeBatch(true); // the snapshot must never be ahead of the journal on disk
+            this->ordersSinceSnapshot_ = 0;
+
+            std::vector<char> bytes(sizeof(SnapshotHeader));
+            SnapshotHeader header = {};
+            std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+            header.version = snapshotVersion;
+            header.realizedPnl = this->portfolio_.getRealizedPnl();
+            header.symbolCount = static_cast<uint32_t>(this->journalToGlobal_.size());
+            header.sequence = this->sequence_;
+            header.journalOffset = this->journalSize_;
+
+            for (SymbolId symbol : this->journalToGlobal_) {
+                std::string_view name = globalSymbols().name(symbol);
+                uint32_t length = static_cast<uint32_t>(name.size());
+                bytes.insert(bytes.end(), reinterpret_cast<const char*>(&length), reinterpret_cast<const char*>(&length) + sizeof(length));
+                bytes.insert(bytes.end(), name.begin(), name.end());
+            }
+            for (const Position &pos : this->portfolio_.getPositions()) {
+                // every held symbol went through addOrder or the previous snapshot, so it already has a journal number
+                SnapshotPosition stored = {*this->globalToJournal_.find(pos.symbol), pos.avgPrice, pos.quantity, pos.markPrice, pos.realizedPnl};
+                bytes.insert(bytes.end(), reinterpret_cast<const char*>(&stored), reinterpret_cast<const char*>(&stored) + sizeof(stored));
+                header.positionCount++;
+            }
+            std::memcpy(bytes.data(), &header, sizeof(header));
+            uint32_t crc = crc32(bytes.data(), bytes.size());
+            bytes.insert(bytes.end(), reinterpret_cast<const char*>(&crc), reinterpret_cast<const char*>(&crc) + sizeof(crc));
+
+            std::filesystem::path temporary = this->snapshotPath();
+            temporary += ".tmp";
+            {
+                AppendFile file(temporary.string(), true);
+                file.write(bytes.data(), bytes.size());
+                file.sync(); // on disk before it replaces the old snapshot
+            }
+            std::filesystem::rename(temporary, this->snapshotPath()); // atomic replace
+        }
+
+        Portfolio& portfolio() {
+            return this->portfolio_;
+        }
+
+        const RecoveryStats& recoveryStats() const {
+            return this->recovery_;
+        }
+};
+
+// --- Limit order book ---
+// Portfolio only records our own fills. The order book below is the matching side: resting limit orders wait at their
+// price, an incoming order that crosses the spread trades against them, best price first and, within one price,
+// oldest first (price-time priority).
+//
+// The add / cancel / match path never allocates once the pools are warm: orders and price levels are nodes in
+// NodePools, linked into intrusive lists through index fields stored inside the nodes themselves,
+// so putting a node into a list or taking it out only rewrites a few integers.
+
+using OrderId = uint64_t;
+
+// Index into a NodePool, nilIndex plays the role of nullptr.
+constexpr uint32_t nilIndex = std::numeric_limits<uint32_t>::max();
+
+// Object pool addressed by 32-bit index. Released nodes go on a free list and are handed out again,
+// so after warm-up allocate() and release() never touch the heap.
+template <typename T>
+class NodePool {
+    private:
+        std::vector<T> nodes_;
+        std::vector<uint32_t> free_;
+
+    public:
+        void reserve(size_t count) {
+            this->nodes_.reserve(count);
+            this->free_.reserve(count);
+        }
+
+        uint32_t allocate() {
+            if (!this->free_.empty()) {
+                uint32_t index = this->free_.back();
+                this->free_.pop_back();
+                return index;
+            }
+            this->nodes_.emplace_back();
+            // the free list can at most hold every node, growing it here keeps release() allocation free
+            this->free_.reserve(this->nodes_.capacity());
+            return static_cast<uint32_t>(this->nodes_.size() - 1);
+        }
+
+        void release(uint32_t index) {
+            this->free_.push_back(index);
+        }
+
+        T& operator[](uint32_t index) {
+            return this->nodes_[index];
+        }
+};
+
+// A fill between an incoming order and a resting one, always at the resting order's price.
+struct Trade {
+    SymbolId symbol;
+    OrderId incomingOrderId;
+    OrderId restingOrderId;
+    OrderType incomingType; // BUY means the buyer crossed the spread
+    Price price;
+    Quantity quantity;
+};
+
+// One price-time priority book for a single symbol.
+// Prices are kept as integer multiples of tickSize, so equal prices always land on the same level.
+class OrderBook {
+    private:
+        struct BookOrder {
+            OrderId id;
+            Quantity quantity; // still open
+            OrderType type;
+            uint32_t level;
+            uint32_t prev; // neighbours in the level's FIFO queue
+            uint32_t next;
+        };
+
+        struct PriceLevel {
+            int64_t ticks;
+            Quantity quantity; // sum over the level's orders
+            uint32_t head; // oldest order, matched first
+            uint32_t tail;
+            uint32_t better; // neighbouring levels on the same side
+            uint32_t worse;
+        };
+
+        // everything that differs between the bid and the ask side
+        struct Side {
+            uint32_t best = nilIndex;
+            FlatHashMap<int64_t, uint32_t> levels; // ticks -> level
+            bool isBid;
+
+            // true if a level at ticks a is better than one at b: higher bids, lower asks
+            bool better(int64_t a, int64_t b) const {
+                return this->isBid ? a > b : a < b;
+            }
+        };
+
+        SymbolId symbol_;
+        Price tickSize_;
+        NodePool<BookOrder> orders_;
+        NodePool<PriceLevel> levels_;
+        FlatHashMap<OrderId, uint32_t> orderIndex_;
+        Side bids_;
+        Side asks_;
+
+        Side& sideOf(OrderType type) {
+            return type == OrderType::BUY ? this->bids_ : this->asks_;
+        }
+
+        // Level for ticks on side, created and linked into its sorted place if it does not exist yet.
+        uint32_t findOrCreateLevel(Side& side, int64_t ticks) {
+            if (uint32_t* existing = side.levels.find(ticks)) {
+                return *existing;
+            }
+            uint32_t index = this->levels_.allocate();
+            PriceLevel &level = this->levels_[index];
+            level = {ticks, Quantity(), nilIndex, nilIndex, nilIndex, nilIndex};
+
+            // walk from the best level until the first one that is worse, new levels are usually close to the top
+            uint32_t better = nilIndex;
+            uint32_t worse = side.best;
+            while (worse != nilIndex && !side.better(ticks, this->levels_[worse].ticks)) {
+                better = worse;
+                worse = this->levels_[worse].worse;
+            }
+            level.better = better;
+            level.worse = worse;
+            if (better != nilIndex) this->levels_[better].worse = index; else side.best = index;
+            if (worse != nilIndex) this->levels_[worse].better = index;
+
+            side.levels.insert(ticks, index);
+            return index;
+        }
+
+        // Nearest tick to price. With fixed-point prices this is integer division, no floating point rounding surprises.
+        int64_t toTicks(Price price) const {
+            int64_t half = this->tickSize_.raw() / 2;
+            return (price.raw() + (price.raw() >= 0 ? half : -half)) / this->tickSize_.raw();
+        }
+
+        Price fromTicks(int64_t ticks) const {
+            return Price::fromRaw(ticks * this->tickSize_.raw());
+        }
+
+        void removeLevel(Side& side, uint32_t index) {
+            PriceLevel &level = this->levels_[index];
+            if (level.better != nilIndex) this->levels_[level.better].worse = level.worse; else side.best = level.worse;
+            if (level.worse != nilIndex) this->levels_[level.worse].better = level.better;
+            side.levels.erase(level.ticks);
+            this->levels_.release(index);
+        }
+
+        // Takes an order out of its level (and the level out of the book if it empties) and frees its node.
+        void removeOrder(Side& side, uint32_t index) {
+            BookOrder &order = this->orders_[index];
+            PriceLevel &level = this->levels_[order.level];
+            if (order.prev != nilIndex) this->orders_[order.prev].next = order.next; else level.head = order.next;
+            if (order.next != nilIndex) this->orders_[order.next].prev = order.prev; else level.tail = order.prev;
+            level.quantity -= order.quantity;
+            if (level.head == nilIndex) {
+                this->removeLevel(side, order.level);
+            }
+            this->orderIndex_.erase(order.id);
+            this->orders_.release(index);
+        }
+
+    public:
+        OrderBook(SymbolId symbol, Price tickSize) : symbol_(symbol), tickSize_(tickSize) {
+            this->bids_.isBid = true;
+            this->asks_.isBid = false;
+        }
+
+        // Pre-sizes the pools and hash maps so that up to restingOrders orders never cause an allocation.
+        // Orders cluster on a few prices near the top of the book, so the level structures get a smaller share:
+        // oversizing them would only spread the hot levels over more cache lines.
+        void reserve(size_t restingOrders) {
+            size_t levels = std::min<size_t>(restingOrders, 1024);
+            this->orders_.reserve(restingOrders);
+            this->orderIndex_.reserve(restingOrders);
+            this->levels_.reserve(levels);
+            this->bids_.levels.reserve(levels);
+            this->asks_.levels.reserve(levels);
+        }
+
+        // Matches an incoming limit order against the opposite side, calling onTrade(const Trade&) for every fill,
+        // and rests whatever is left at its limit price.
+        template <typename OnTrade>
+        void addLimitOrder(OrderId id, OrderType type, Price price, Quantity quantity, OnTrade&& onTrade) {
+            int64_t ticks = this->toTicks(price);
+            Side &opposite = this->sideOf(type == OrderType::BUY ? OrderType::SELL : OrderType::BUY);
+
+            // keep matching while the best opposite level is at least as good as our limit
+            while (quantity > Quantity() && opposite.best != nilIndex && !opposite.better(ticks, this->levels_[opposite.best].ticks)) {
+                uint32_t levelIndex = opposite.best;
+                uint32_t restingIndex = this->levels_[levelIndex].head;
+                BookOrder &resting = this->orders_[restingIndex];
+
+                Quantity fill = std::min(quantity, resting.quantity);
+                onTrade(Trade{this->symbol_, id, resting.id, type, this->fromTicks(this->levels_[levelIndex].ticks), fill});
+                quantity -= fill;
+
+                if (fill == resting.quantity) {
+                    this->removeOrder(opposite, restingIndex);
+                } else {
+                    resting.quantity -= fill; // partial fill, the order keeps its place in the queue
+                    this->levels_[levelIndex].quantity -= fill;
+                }
+            }
+            if (quantity <= Quantity()) {
+                return;
+            }
+
+            Side &side = this->sideOf(type);
+            uint32_t levelIndex = this->findOrCreateLevel(side, ticks);
+            PriceLevel &level = this->levels_[levelIndex];
+            uint32_t index = this->orders_.allocate();
+            this->orders_[index] = {id, quantity, type, levelIndex, level.tail, nilIndex};
+            // join the back of the queue
+            if (level.tail != nilIndex) this->orders_[level.tail].next = index; else level.head = index;
+            level.tail = index;
+            level.quantity += quantity;
+            this->orderIndex_.insert(id, index);
+        }
+
+        // Removes a resting order. Returns false if it is not in the book (unknown, filled or already cancelled).
+        bool cancel(OrderId id) {
+            uint32_t* index = this->orderIndex_.find(id);
+            if (index == nullptr) {
+                return false;
+            }
+            this->removeOrder(this->sideOf(this->orders_[*index].type), *index);
+            return true;
+        }
+
+        // Best bid / ask price, empty when that side has no orders.
+        std::optional<Price> bestBid() {
+            return this->bids_.best == nilIndex ? std::nullopt : std::optional<Price>(this->fromTicks(this->levels_[this->bids_.best].ticks));
+        }
+
+        std::optional<Price> bestAsk() {
+            return this->asks_.best == nilIndex ? std::nullopt : std::optional<Price>(this->fromTicks(this->levels_[this->asks_.best].ticks));
+        }
+
+        // Total open quantity resting at price on the given side.
+        Quantity quantityAt(OrderType type, Price price) {
+            uint32_t* level = this->sideOf(type).levels.find(this->toTicks(price));
+            return level == nullptr ? Quantity() : this->levels_[*level].quantity;
+        }
+};
+
+// One OrderBook per symbol plus the id counter and the trade output.
+// Trades go to the listener passed in the constructor as soon as they happen.
+class MatchingEngine {
+    private:
+        std::vector<OrderBook> books_; // indexed by SymbolId, the ids are dense
+        Price tickSize_;
+        size_t reservePerBook_;
+        OrderId nextId_ = 1;
+        std::function<void(const Trade&)> onTrade_;
+
+        OrderBook& bookFor(SymbolId symbol) {
+            while (this->books_.size() <= symbol) {
+                this->books_.emplace_back(static_cast<SymbolId>(this->books_.size()), this->tickSize_);
+                this->books_.back().reserve(this->reservePerBook_);
+            }
+            return this->books_[symbol];
+        }
+
+    public:
+        MatchingEngine(std::function<void(const Trade&)> onTrade, Price tickSize = Price(0.01), size_t reservePerBook = 1024)
+            : tickSize_(tickSize), reservePerBook_(reservePerBook), onTrade_(std::move(onTrade)) {}
+
+        // Submits order as a limit order at order.price and returns the id it was given.
+        OrderId submit(const Order &order) {
+            OrderId id = this->nextId_++;
+            this->bookFor(order.symbol).addLimitOrder(id, order.type, order.price, order.quantity, this->onTrade_);
+            return id;
+        }
+
+        bool cancel(SymbolId symbol, OrderId id) {
+            return this->bookFor(symbol).cancel(id);
+        }
+
+        OrderBook& book(SymbolId symbol) {
+            return this->bookFor(symbol);
+        }
+};
+
+// --- Concurrent ingestion ---
+// Portfolio is not thread-safe. Instead of putting a lock around it, orders from any number of producer threads go
+// through a lock-free ring buffer to one consumer thread, and only that thread touches the Portfolio.
+// Producers never wait for each other or for the consumer unless the ring is full.
+
+// Keeps hot atomics on their own cache line, so a producer bumping the tail does not slow down the consumer's head.
+constexpr size_t cacheLineSize = 64;
+
+// Bounded multi-producer single-consumer queue (Dmitry Vyukov's design).
+// Every cell has a sequence number saying whose turn it is: a producer may fill cell i when its sequence equals
+// the producer's ticket, the consumer may take it when it equals ticket + 1. Producers claim tickets with one
+// compare-and-swap on the tail; the consumer owns the head alone and needs no atomic read-modify-write at all.
+template <typename T>
+class MpscRing {
+    private:
+        struct alignas(cacheLineSize) Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_;
+        alignas(cacheLineSize) std::atomic<size_t> tail_{0}; // next ticket for producers
+        alignas(cacheLineSize) size_t head_ = 0;              // next cell for the consumer
+
+    public:
+        // capacity is rounded up to a power of two
+        explicit MpscRing(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity) {
+                size *= 2;
+            }
+            this->cells_ = std::make_unique<Cell[]>(size);
+            this->mask_ = size - 1;
+            for (size_t i = 0; i < size; ++i) {
+                this->cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Any thread. False if the ring is full.
+        bool tryPush(const T& value) {
+            size_t ticket = this->tail_.load(std::memory_order_relaxed);
+            while (true) {
+                Cell &cell = this->cells_[ticket & this->mask_];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                if (sequence == ticket) {
+                    // the cell is free, try to claim it; on failure ticket is reloaded and we retry
+                    if (this->tail_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+                        cell.value = value;
+                        cell.sequence.store(ticket + 1, std::memory_order_release); // hand it to the consumer
+                        return true;
+                    }
+                } else if (sequence < ticket) {
+                    return false; // the consumer has not emptied this cell from the previous lap yet
+                } else {
+                    ticket = this->tail_.load(std::memory_order_relaxed); // another producer got there first
+                }
+            }
+        }
+
+        // Consumer thread only. False if the ring is empty.
+        bool tryPop(T& value) {
+            Cell &cell = this->cells_[this->head_ & this->mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != this->head_ + 1) {
+                return false;
+            }
+            value = cell.value;
+            // free the cell for the producer one lap ahead
+            cell.sequence.store(this->head_ + this->mask_ + 1, std::memory_order_release);
+            this->head_++;
+            return true;
+        }
+
+        size_t capacity() const {
+            return this->mask_ + 1;
+        }
+};
+
+// What a thread does while the ring is empty (consumer) or full (producers).
+enum class WaitStrategy {
+    BusySpin, // lowest latency, burns a whole core even when idle
+    Yield,    // spins but lets other threads run, good when there are more threads than cores
+    Block     // the consumer sleeps until a producer wakes it, cheapest when idle, slowest to react
+};
+
+// Moves orders from producer threads into a Portfolio owned by one consumer thread.
+class OrderPipeline {
+    public:
+        // Called on the consumer thread after each order is applied, with the time it was submitted.
+        using AppliedCallback = std::function<void(const Order&, std::chrono::steady_clock::time_point)>;
+
+    private:
+        struct Item {
+            Order order;
+            std::chrono::steady_clock::time_point submitted;
+        };
+
+        Portfolio &portfolio_;
+        MpscRing<Item> ring_;
+        WaitStrategy waitStrategy_;
+        AppliedCallback onApplied_;
+        std::atomic<bool> stopping_{false};
+        // Block strategy: the consumer sets sleeping_ before it waits on wakeups_, producers only
+        // pay for a notify when it is actually asleep
+        alignas(cacheLineSize) std::atomic<bool> sleeping_{false};
+        std::atomic<uint32_t> wakeups_{0};
+        std::thread consumer_;
+
+        void apply(const Item &item) {
+            this->portfolio_.addOrder(item.order);
+            if (this->onApplied_) {
+                this->onApplied_(item.order, item.submitted);
+            }
+        }
+
+        void wakeConsumer() {
+            // pairs with the fence in consume(): either this load sees sleeping_, or the consumer's re-check sees the order
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->sleeping_.load(std::memory_order_relaxed)) {
+                this->wakeups_.fetch_add(1, std::memory_order_relaxed);
+                this->wakeups_.notify_one();
+            }
+        }
+
+        void consume(int cpu) {
+            pinCurrentThread(cpu);
+            Item item;
+            int idlePolls = 0;
+            while (true) {
+                if (this->ring_.tryPop(item)) {
+                    idlePolls = 0;
+                    this->apply(item);
+                    continue;
+                }
+                if (this->stopping_.load(std::memory_order_acquire)) {
+                    // producers are done, one last look so nothing submitted before stop() is lost
+                    while (this->ring_.tryPop(item)) {
+                        this->apply(item);
+                    }
+                    return;
+                }
+                // a short spin first in every mode: under load the next order is usually only nanoseconds away
+                if (this->waitStrategy_ == WaitStrategy::BusySpin || ++idlePolls < 64) {
+                    continue;
+                }
+                if (this->waitStrategy_ == WaitStrategy::Yield) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                uint32_t seen = this->wakeups_.load(std::memory_order_relaxed);
+                this->sleeping_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                // re-check after announcing the sleep, a producer may have pushed in between
+                bool popped = this->ring_.tryPop(item);
+                if (!popped && !this->stopping_.load(std::memory_order_acquire)) {
+                    this->wakeups_.wait(seen, std::memory_order_relaxed);
+                }
+                this->sleeping_.store(false, std::memory_order_relaxed);
+                idlePolls = 0;
+                if (popped) {
+                    this->apply(item);
+                }
+            }
+        }
+
+    public:
+        // Starts the consumer thread. cpu >= 0 pins it to that core (Linux only, ignored elsewhere).
+        OrderPipeline(Portfolio &portfolio, size_t capacity = 65536, WaitStrategy waitStrategy = WaitStrategy::Yield,
+                      int cpu = -1, AppliedCallback onApplied = nullptr)
+            : portfolio_(portfolio), ring_(capacity), waitStrategy_(waitStrategy), onApplied_(std::move(onApplied)) {
+            this->consumer_ = std::thread([this, cpu] { this->consume(cpu); });
+        }
+
+        OrderPipeline(const OrderPipeline&) = delete;
+        OrderPipeline& operator=(const OrderPipeline&) = delete;
+
+        ~OrderPipeline() {
+            this->stop();
+        }
+
+        // Thread-safe. Waits (per the wait strategy) while the ring is full.
+        void submit(const Order &order) {
+            Item item = {order, std::chrono::steady_clock::now()};
+            while (!this->ring_.tryPush(item)) {
+                // the ring is full, the consumer is behind; make sure it is awake and give it time
+                this->wakeConsumer();
+                if (this->waitStrategy_ != WaitStrategy::BusySpin) {
+                    std::this_thread::yield();
+                }
+            }
+            if (this->waitStrategy_ == WaitStrategy::Block) {
+                this->wakeConsumer();
+            }
+        }
+
+        // Applies everything submitted so far and joins the consumer. Call after all producers have finished.
+        void stop() {
+            if (!this->consumer_.joinable()) {
+                return;
+            }
+            this->stopping_.store(true, std::memory_order_release);
+            this->wakeups_.fetch_add(1, std::memory_order_seq_cst);
+            this->wakeups_.notify_one();
+            this->consumer_.join();
+        }
+
+        // Pins the calling thread to one core, so it keeps its caches and is never migrated.
+        static void pinCurrentThread(int cpu) {
+#if defined(__linux__)
+            if (cpu < 0) {
+                return;
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+                std::cout << "Error: could not pin thread to CPU " << cpu << std::endl;
+            }
+#else
+            (void)cpu;
+#endif
+        }
+};
+
+// --- Benchmarks ---
+
+// Runs f once and returns the wall clock time it took in seconds.
+template <typename F>
+double timeSeconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Random BUY and SELL orders over symbolCount tickers. SELLs never exceed the quantity held,
+// a quarter of them close the whole position so removal is exercised too.
+std::vector<Order> generateSyntheticOrders(size_t count, size_t symbolCount) {
+    std::vector<SymbolId> tickers;
+    for (size_t i = 0; i < symbolCount; ++i) {
+        tickers.push_back(globalSymbols().intern("SYM" + std::to_string(i)));
+    }
+
+    std::mt19937 eng(42); // fixed seed for reproducibility
+    std::uniform_int_distribution<size_t> symbolDistr(0, symbolCount - 1);
+    std::uniform_int_distribution<int> quantityDistr(1, 100);
+    std::uniform_int_distribution<int> priceDistr(10, 500);
+    std::uniform_int_distribution<int> percentDistr(0, 99);
+
+    std::vector<Quantity> held(symbolCount);
+    std::vector<Order> orders;
+    orders.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        size_t symbol = symbolDistr(eng);
+        Date date = Date::fromDays(Date(1, 1, 2025).days() + static_cast<int32_t>(i / 10'000)); // 10k orders a day, in date order
+        if (held[symbol] > Quantity() && percentDistr(eng) < 40) {
+            Quantity quantity = percentDistr(eng) < 25 ? held[symbol] : std::min(held[symbol], Quantity(quantityDistr(eng)));
+            held[symbol] -= quantity;
+            orders.push_back({tickers[symbol], Price(priceDistr(eng)), quantity, OrderType::SELL, date});
+        } else {
+            Quantity quantity(quantityDistr(eng));
+            held[symbol] += quantity;
+            orders.push_back({tickers[symbol], Price(priceDistr(eng)), quantity, OrderType::BUY, date});
+        }
+    }
+    return orders;
+}
+
+// Order throughput of addOrder.
+void runOrderBenchmark(size_t orderCount, size_t symbolCount) {
+    std::vector<Order> orders = generateSyntheticOrders(orderCount, symbolCount);
+    std::cout << orderCount << " orders over " << symbolCount << " symbols" << std::endl;
+
+    Portfolio portfolio;
+    double seconds = timeSeconds([&] {
+        for (const Order &order : orders) {
+            portfolio.addOrder(order);
+        }
+    });
+    std::cout << "addOrder: " << seconds * 1000.0 << " ms, " << orderCount / seconds / 1e6 << " M orders/s, "
+              << seconds / orderCount * 1e9 << " ns/order (total value " << portfolio.getTotalValue() << ")" << std::endl;
+}
+
+// Prints p50 / p99 / p99.9 / max of a set of latencies given in nanoseconds.
+void printLatencies(const std::string& name, std::vector<double>& nanoseconds) {
+    if (nanoseconds.empty()) {
+        return;
+    }
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    auto percentile = [&](double p) {
+        return nanoseconds[std::min(nanoseconds.size() - 1, static_cast<size_t>(p * nanoseconds.size()))];
+    };
+    std::cout << name << " (" << nanoseconds.size() << " ops): p50 " << percentile(0.50) << " ns, p99 " << percentile(0.99)
+              << " ns, p99.9 " << percentile(0.999) << " ns, max " << nanoseconds.back() << " ns" << std::endl;
+}
+
+// Replays a synthetic order flow through the MatchingEngine and times every operation on its own.
+// Most orders rest a few ticks away from the mid price, some cross it and trade, and a third of the events cancel an earlier order.
+void runOrderBookBenchmark(size_t eventCount, size_t symbolCount) {
+    struct FlowEvent {
+        bool isCancel;
+        Order order;       // for adds
+        size_t addIndex;   // for cancels: which earlier add to cancel
+    };
+
+    std::vector<SymbolId> symbols;
+    for (size_t i = 0; i < symbolCount; ++i) {
+        symbols.push_back(globalSymbols().intern("SYM" + std::to_string(i)));
+    }
+
+    std::mt19937 eng(42); // fixed seed for reproducibility
+    std::uniform_int_distribution<size_t> symbolDistr(0, symbolCount - 1);
+    std::uniform_int_distribution<int> percentDistr(0, 99);
+    std::uniform_int_distribution<int> offsetDistr(1, 20);
+    std::uniform_int_distribution<int> quantityDistr(1, 100);
+
+    std::vector<FlowEvent> flow;
+    flow.reserve(eventCount);
+    size_t addCount = 0;
+    for (size_t i = 0; i < eventCount; ++i) {
+        if (addCount > 0 && percentDistr(eng) < 30) {
+            flow.push_back({true, {}, std::uniform_int_distribution<size_t>(0, addCount - 1)(eng)});
+            continue;
+        }
+        bool buy = percentDistr(eng) < 50;
+        bool aggressive = percentDistr(eng) < 20;
+        // mid price is 100.00, passive orders sit 1..20 ticks on their own side, aggressive ones reach 1..20 ticks across
+        int offset = aggressive ? offsetDistr(eng) : -offsetDistr(eng);
+        Price price = Price(100) + Price::fromRaw((buy ? offset : -offset) * Price(0.01).raw());
+        flow.push_back({false, {symbols[symbolDistr(eng)], price, Quantity(quantityDistr(eng)), buy ? OrderType::BUY : OrderType::SELL, {1, 1, 2025}}, 0});
+        addCount++;
+    }
+
+    size_t tradeCount = 0;
+    MatchingEngine engine([&tradeCount](const Trade&) { tradeCount++; }, Price(0.01), eventCount / symbolCount + 1);
+
+    std::vector<OrderId> ids(addCount);
+    std::vector<SymbolId> idSymbols(addCount);
+    std::vector<double> restingAdds, matchingAdds, cancels;
+    restingAdds.reserve(eventCount);
+    matchingAdds.reserve(eventCount);
+    cancels.reserve(eventCount);
+
+    size_t addIndex = 0;
+    for (const FlowEvent &event : flow) {
+        size_t tradesBefore = tradeCount;
+        // look up the cancel target before starting the clock, only the engine's work is measured
+        SymbolId cancelSymbol = event.isCancel ? idSymbols[event.addIndex] : 0;
+        OrderId cancelId = event.isCancel ? ids[event.addIndex] : 0;
+        auto start = std::chrono::steady_clock::now();
+        if (event.isCancel) {
+            engine.cancel(cancelSymbol, cancelId);
+        } else {
+            ids[addIndex] = engine.submit(event.order);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        if (event.isCancel) {
+            cancels.push_back(ns);
+        } else {
+            idSymbols[addIndex++] = event.order.symbol;
+            (tradeCount > tradesBefore ? matchingAdds : restingAdds).push_back(ns);
+        }
+    }
+
+    std::cout << eventCount << " events over " << symbolCount << " symbols, " << tradeCount << " trades" << std::endl;
+    printLatencies("add, rests   ", restingAdds);
+    printLatencies("add, matches ", matchingAdds);
+    printLatencies("cancel       ", cancels);
+    std::cout << "(each measurement includes two steady_clock reads)" << std::endl;
+}
+
+// Counts calls to the global operator new, so the journal benchmark can report allocations per order.
+// Replacing the global allocation functions changes them for the whole program, so it is opt in:
+// build with -DCOUNT_ALLOCATIONS to get the counts, everything else always runs on the normal allocator.
+// Atomic because the pipeline's producer and consumer threads allocate too.
+#if defined(COUNT_ALLOCATIONS)
+constexpr bool countingAllocations = true;
+std::atomic<size_t> allocationCount{0};
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC inlines these into standard library code and then warns that free() does not match new; keeping them out of line avoids that.
+#if defined(__GNUC__)
+#define OUT_OF_LINE __attribute__((noinline))
+#else
+#define OUT_OF_LINE
+#endif
+
+OUT_OF_LINE void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+OUT_OF_LINE void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#else
+constexpr bool countingAllocations = false;
+std::atomic<size_t> allocationCount{0}; // stays 0
+#endif
+
+// Resident memory of this process in MB, read from /proc on Linux (0 elsewhere).
+double residentMemoryMb() {
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages = 0, residentPages = 0;
+    if (statm >> totalPages >> residentPages) {
+        return residentPages * 4096.0 / 1e6;
+    }
+    return 0.0;
+}
+
+// Highest resident memory this process has had so far in MB, same source.
+double peakResidentMemoryMb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stod(line.substr(6)) * 1024.0 / 1e6; // reported in KiB
+        }
+    }
+    return 0.0;
+}
+
+// Appends orderCount orders to a std::vector<Order> and to an OrderJournal and compares
+// time, allocations per order and resident memory growth.
+void runJournalBenchmark(size_t orderCount) {
+    Order order = {globalSymbols().intern("AAPL"), Price(150), Quantity(10), OrderType::BUY, {1, 1, 2025}};
+
+    auto measure = [&](const std::string& name, auto&& append) {
+        size_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        double memoryBefore = residentMemoryMb();
+        double seconds = timeSeconds([&] {
+            for (size_t i = 0; i < orderCount; ++i) {
+                order.quantity = Quantity(i % 100 + 1);
+                append(order);
+            }
+        });
+        std::cout << name << ": " << seconds / orderCount * 1e9 << " ns/order, ";
+        if (countingAllocations) {
+            std::cout << static_cast<double>(allocationCount.load(std::memory_order_relaxed) - allocationsBefore) / orderCount << " allocations/order, ";
+        } else {
+            std::cout << "allocations/order not counted (build with -DCOUNT_ALLOCATIONS), ";
+        }
+        std::cout << "RSS growth " << residentMemoryMb() - memoryBefore << " MB, peak RSS so far " << peakResidentMemoryMb() << " MB" << std::endl;
+    };
+
+    std::cout << orderCount << " orders, sizeof(Order): " << sizeof(Order) << " bytes, "
+              << orderCount * sizeof(Order) / 1e6 << " MB of order data" << std::endl;
+    // the journal runs first: the peak only ever grows, so the vector's reallocation spike shows up as a second, higher peak
+    {
+        OrderJournal journal;
+        measure("OrderJournal       ", [&journal](const Order &o) { journal.append(o); });
+    }
+    {
+        std::vector<Order> orders;
+        measure("std::vector<Order> ", [&orders](const Order &o) { orders.push_back(o); });
+    }
+}
+
+// Write-ahead journal: append throughput per fsync policy, recovery speed with and without snapshots,
+// and (on POSIX) a real crash: a child process journals orders until it is killed with SIGKILL,
+// then the journal is recovered and checked against the same orders applied in memory.
+void runPersistenceBenchmark(size_t orderCount) {
+    const std::string directory = "bench_wal";
+    std::vector<Order> orders = generateSyntheticOrders(orderCount, 5'000);
+    std::cout << orderCount << " orders, journal in ./" << directory << std::endl;
+
+    // positions after the first count orders, computed without any journal
+    auto expectedValue = [&orders](uint64_t count) {
+        Portfolio reference;
+        for (uint64_t i = 0; i < count; ++i) {
+            reference.addOrder(orders[i]);
+        }
+        return reference.getTotalValue();
+    };
+
+    const std::pair<const char*, FsyncPolicy> policies[] = {
+        {"fsync never      ", FsyncPolicy::Never},
+        {"fsync every 100ms", FsyncPolicy::Interval},
+        {"fsync every batch", FsyncPolicy::EveryBatch},
+    };
+    for (const auto &[name, policy] : policies) {
+        std::filesystem::remove_all(directory);
+        PersistenceOptions options;
+        options.fsyncPolicy = policy;
+        options.snapshotEvery = 0;
+        double seconds = timeSeconds([&] {
+            PersistentPortfolio portfolio(directory, options);
+            for (const Order &order : orders) {
+                portfolio.addOrder(order);
+            }
+            portfolio.commit();
+        });
+        std::cout << name << ": " << orderCount / seconds / 1e6 << " M orders/s, "
+                  << std::filesystem::file_size(std::filesystem::path(directory) / "orders.wal") / 1e6 << " MB journal" << std::endl;
+    }
+
+    auto reportRecovery = [](const std::string& name, const PersistentPortfolio &portfolio) {
+        const PersistentPortfolio::RecoveryStats &stats = portfolio.recoveryStats();
+        std::cout << name << ": " << stats.seconds * 1000.0 << " ms, " << stats.snapshotSequence << " orders from snapshot, "
+                  << stats.replayedOrders << " replayed (" << stats.replayedOrders / std::max(stats.seconds, 1e-9) / 1e6
+                  << " M orders/s), " << stats.truncatedBytes << " torn bytes dropped" << std::endl;
+    };
+
+    // the totals a restart must reproduce, whether it restores a snapshot or replays everything
+    struct Totals {
+        Money cost, market, realized;
+        bool operator==(const Totals&) const = default;
+    };
+    auto totalsOf = [](Portfolio &portfolio) {
+        return Totals{portfolio.getTotalValue(), portfolio.getMarketValue(), portfolio.getRealizedPnl()};
+    };
+    Totals replayed;
+
+    // the last policy's journal has no snapshot, so this replays everything
+    {
+        PersistentPortfolio recovered(directory);
+        reportRecovery("Recovery, full replay   ", recovered);
+        replayed = totalsOf(recovered.portfolio());
+    }
+    {
+        std::filesystem::remove_all(directory);
+        PersistenceOptions options;
+        options.snapshotEvery = std::max<size_t>(orderCount / 10, 1);
+        {
+            PersistentPortfolio portfolio(directory, options);
+            for (const Order &order : orders) {
+                portfolio.addOrder(order);
+            }
+        }
+        PersistentPortfolio recovered(directory);
+        reportRecovery("Recovery, with snapshots", recovered);
+        std::cout << "Snapshot recovery " << (totalsOf(recovered.portfolio()) == replayed ? "matches" : "DIFFERS from")
+                  << " full replay (cost, market value, realized P&L)" << std::endl;
+    }
+
+#if !defined(_WIN32)
+    std::filesystem::remove_all(directory);
+    std::cout.flush();
+    pid_t child = fork();
+    if (child < 0) {
+        std::cerr << "Error: fork failed" << std::endl;
+        return;
+    }
+    if (child == 0) {
+        PersistenceOptions options;
+        options.snapshotEvery = std::max<size_t>(orderCount / 10, 1);
+        PersistentPortfolio portfolio(directory, options);
+        for (const Order &order : orders) {
+            portfolio.addOrder(order);
+        }
+        portfolio.commit();
+        _exit(0); // ran out of orders before the kill, nothing left to test
+    }
+    // kill it part way through, whatever it is doing at that moment
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    kill(child, SIGKILL);
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFSIGNALED(status)) {
+        std::cout << "Crash test: the writer finished before it was killed, try more orders" << std::endl;
+        return;
+    }
+
+    PersistentPortfolio recovered(directory);
+    reportRecovery("Recovery after SIGKILL  ", recovered);
+    uint64_t recoveredOrders = recovered.recoveryStats().snapshotSequence + recovered.recoveryStats().replayedOrders;
+    Money expected = expectedValue(recoveredOrders);
+    std::cout << "Crash test: " << recoveredOrders << " orders survived, total value " << recovered.portfolio().getTotalValue()
+              << (recovered.portfolio().getTotalValue() == expected ? " matches" : " DOES NOT match") << " the in-memory result" << std::endl;
+#endif
+}
+
+// Mark-to-market throughput: a random walk of price ticks over every held symbol. Compares the incremental totals
+// with recomputing the sum over all positions on each read (the old getTotalValue), and checks that the
+// running market value still equals a fresh recomputation at the end.
+void runValuationBenchmark(size_t tickCount, size_t symbolCount) {
+    Portfolio portfolio;
+    for (const Order &order : generateSyntheticOrders(symbolCount * 20, symbolCount)) {
+        portfolio.addOrder(order);
+    }
+    std::vector<SymbolId> held;
+    for (const Position &pos : portfolio.getPositions()) {
+        held.push_back(pos.symbol);
+    }
+
+    std::mt19937 eng(7);
+    std::uniform_int_distribution<size_t> symbolDistr(0, held.size() - 1);
+    std::normal_distribution<double> returnDistr(0.0, 0.001);
+    std::vector<double> prices(held.size());
+    for (size_t i = 0; i < held.size(); ++i) {
+        prices[i] = portfolio.getPositions()[i].markPrice.toDouble();
+    }
+    std::vector<PriceTick> ticks;
+    ticks.reserve(tickCount);
+    for (size_t i = 0; i < tickCount; ++i) {
+        size_t k = symbolDistr(eng);
+        prices[k] *= 1.0 + returnDistr(eng);
+        ticks.push_back({held[k], Price(prices[k])});
+    }
+    std::cout << tickCount << " ticks over " << held.size() << " held symbols" << std::endl;
+
+    double checksum = 0.0; // a Money sum over millions of reads would overflow
+    double seconds = timeSeconds([&] {
+        for (const PriceTick &tick : ticks) {
+            portfolio.updatePrice(tick);
+            checksum += portfolio.getUnrealizedPnl().toDouble(); // read the total after every tick, as a risk check would
+        }
+    });
+    std::cout << "Incremental:       " << seconds / tickCount * 1e9 << " ns/tick incl. one read, "
+              << tickCount / seconds / 1e6 << " M ticks/s (checksum " << checksum << ")" << std::endl;
+
+    Money recomputed;
+    for (const Position &pos : portfolio.getPositions()) {
+        recomputed += pos.markPrice * pos.quantity;
+    }
+    std::cout << "Market value after " << tickCount << " ticks: running " << portfolio.getMarketValue().raw() << ", recomputed "
+              << recomputed.raw() << " (raw units, " << (portfolio.getMarketValue() == recomputed ? "no drift" : "DRIFTED") << ")" << std::endl;
+
+    // recomputing on every read is O(positions), so only a sample of the ticks is timed
+    size_t sampled = std::min<size_t>(tickCount, 20'000);
+    double recomputeChecksum = 0.0;
+    double recomputeSeconds = timeSeconds([&] {
+        for (size_t i = 0; i < sampled; ++i) {
+            portfolio.updatePrice(ticks[i]);
+            Money unrealized;
+            for (const Position &pos : portfolio.getPositions()) {
+                unrealized += (pos.markPrice - pos.avgPrice) * pos.quantity;
+            }
+            recomputeChecksum += unrealized.toDouble();
+        }
+    });
+    std::cout << "Recompute on read: " << recomputeSeconds / sampled * 1e9 << " ns/tick incl. one read (checksum "
+              << recomputeChecksum << ")" << std::endl;
+}
+
+// Throughput and submit-to-apply latency of OrderPipeline for 1, 2, 4 and 8 producer threads and every wait strategy.
+// Throughput is measured flat out. At full load the ring is always full, so the latency would just be the time to
+// drain it; latency is therefore measured separately with the producers paced to a fixed total rate.
+// The orders are all buys, so the interleaving of producers cannot turn a valid sell into an invalid one.
+void runPipelineBenchmark(size_t orderCount, double pacedOrdersPerSecond) {
+    std::vector<Order> orders = generateSyntheticOrders(orderCount, 5'000);
+    for (Order &order : orders) {
+        order.type = OrderType::BUY;
+    }
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    int consumerCpu = static_cast<int>(cores) - 1; // producers are left to the scheduler
+    std::cout << orderCount << " orders, " << cores << " hardware threads, consumer pinned to CPU " << consumerCpu << std::endl;
+
+    // Runs producerCount producers over count orders, at most ordersPerSecond in total (0 = unlimited).
+    // Returns the wall time until every order is applied and fills latencies.
+    auto run = [&](WaitStrategy strategy, size_t producerCount, size_t count, double ordersPerSecond, std::vector<double>& latencies) {
+        Portfolio portfolio;
+        latencies.clear();
+        latencies.reserve(count);
+        std::atomic<bool> go{false};
+
+        OrderPipeline pipeline(portfolio, 65536, strategy, consumerCpu,
+            [&latencies](const Order&, std::chrono::steady_clock::time_point submitted) {
+                latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - submitted).count());
+            });
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < producerCount; ++p) {
+            producers.emplace_back([&, p] {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                auto start = std::chrono::steady_clock::now();
+                std::chrono::duration<double> interval(ordersPerSecond > 0 ? producerCount / ordersPerSecond : 0.0);
+                size_t submitted = 0;
+                // producer p submits every producerCount-th order
+                for (size_t i = p; i < count; i += producerCount) {
+                    if (ordersPerSecond > 0) {
+                        auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval * submitted);
+                        while (std::chrono::steady_clock::now() < due) {
+                            std::this_thread::yield();
+                        }
+                    }
+                    pipeline.submit(orders[i]);
+                    submitted++;
+                }
+            });
+        }
+        return timeSeconds([&] {
+            go.store(true, std::memory_order_release);
+            for (std::thread &producer : producers) {
+                producer.join();
+            }
+            pipeline.stop();
+        });
+    };
+
+    const std::pair<const char*, WaitStrategy> strategies[] = {
+        {"busy-spin", WaitStrategy::BusySpin},
+        {"yield", WaitStrategy::Yield},
+        {"block", WaitStrategy::Block},
+    };
+    std::vector<double> latencies;
+    for (const auto &[strategyName, strategy] : strategies) {
+        for (size_t producerCount : {1, 2, 4, 8}) {
+            double seconds = run(strategy, producerCount, orderCount, 0.0, latencies);
+            std::cout << strategyName << ", " << producerCount << " producer(s): " << orderCount / seconds / 1e6 << " M orders/s flat out" << std::endl;
+            size_t pacedCount = std::min<size_t>(orderCount, static_cast<size_t>(pacedOrdersPerSecond / 4)); // a quarter second
+            run(strategy, producerCount, pacedCount, pacedOrdersPerSecond, latencies);
+            printLatencies("  latency at " + std::to_string(static_cast<long>(pacedOrdersPerSecond)) + " orders/s", latencies);
+        }
+    }
+}
+
+// The position arithmetic of the order path on its own, once with doubles and once with the fixed-point types:
+// an average price update per buy, cost basis and realized profit per sell. One position, data in cache,
+// so the difference is the arithmetic itself (mostly integer versus floating point division).
+template <typename P, typename Q, typename M, typename Average>
+M runPositionMath(const std::vector<P>& prices, const std::vector<Q>& quantities, Average average, size_t rounds) {
+    M realized{};
+    for (size_t round = 0; round < rounds; ++round) {
+        // a fresh position every round, a position that kept growing would run out of Money's range
+        P avgPrice{};
+        Q held{};
+        for (size_t i = 0; i < prices.size(); ++i) {
+            if (i % 3 != 2 || held == Q()) {
+                M cost = avgPrice * held + prices[i] * quantities[i];
+                held += quantities[i];
+                avgPrice = average(cost, held);
+            } else {
+                Q sold = std::min(held, quantities[i]);
+                realized += (prices[i] - avgPrice) * sold;
+                held -= sold;
+            }
+        }
+    }
+    return realized;
+}
+
+void runFixedPointBenchmark(size_t operations) {
+    std::mt19937 eng(42);
+    std::uniform_int_distribution<int> priceDistr(1'000'000, 5'000'000); // 100.0000 to 500.0000
+    std::uniform_int_distribution<int> quantityDistr(1, 100);
+    const size_t size = 4096;
+    std::vector<double> doublePrices, doubleQuantities;
+    std::vector<Price> prices;
+    std::vector<Quantity> quantities;
+    for (size_t i = 0; i < size; ++i) {
+        prices.push_back(Price::fromRaw(priceDistr(eng)));
+        quantities.push_back(Quantity(quantityDistr(eng)));
+        doublePrices.push_back(prices.back().toDouble());
+        doubleQuantities.push_back(quantities.back().toDouble());
+    }
+    size_t rounds = std::max<size_t>(operations / size, 1);
+
+    double doubleResult = 0.0;
+    double doubleSeconds = timeSeconds([&] {
+        doubleResult = runPositionMath<double, double, double>(doublePrices, doubleQuantities,
+            [](double cost, double quantity) { return cost / quantity; }, rounds);
+    });
+    Money fixedResult;
+    double fixedSeconds = timeSeconds([&] {
+        fixedResult = runPositionMath<Price, Quantity, Money>(prices, quantities, averagePrice, rounds);
+    });
+
+    std::cout << rounds * size << " position updates" << std::endl;
+    std::cout << "double:      " << doubleSeconds / (rounds * size) * 1e9 << " ns/update (realized " << doubleResult << ")" << std::endl;
+    std::cout << "fixed-point: " << fixedSeconds / (rounds * size) * 1e9 << " ns/update (realized " << fixedResult << ")" << std::endl;
+    std::cout << "sizeof(Order): " << sizeof(Order) << " bytes, sizeof(Position): " << sizeof(Position) << " bytes" << std::endl;
+}
+
+// applyOrders with batch sizes from 1 to 100k against addOrder one by one. A few sells are made invalid on purpose,
+// and the error output of both ways is captured and compared along with the resulting positions and totals.
+void runBatchBenchmark(size_t orderCount, size_t symbolCount) {
+    std::vector<Order> orders = generateSyntheticOrders(orderCount, symbolCount);
+    for (size_t i = 0; i < orders.size(); i += 997) {
+        if (orders[i].type == OrderType::SELL) {
+            orders[i].quantity += Quantity(1000); // more than anyone holds
+        }
+    }
+    std::cout << orderCount << " orders over " << symbolCount << " symbols" << std::endl;
+
+    // runs apply on a fresh portfolio with std::cout captured, returns the time and fills output
+    auto run = [&](auto&& apply, std::string& output, Portfolio& portfolio) {
+        std::ostringstream captured;
+        std::streambuf* original = std::cout.rdbuf(captured.rdbuf());
+        double seconds = timeSeconds([&] { apply(portfolio); });
+        std::cout.rdbuf(original);
+        output = captured.str();
+        return seconds;
+    };
+
+    std::string expectedOutput;
+    Portfolio expected;
+    double sequentialSeconds = run([&](Portfolio& portfolio) {
+        for (const Order &order : orders) {
+            portfolio.addOrder(order);
+        }
+    }, expectedOutput, expected);
+    size_t errorCount = static_cast<size_t>(std::count(expectedOutput.begin(), expectedOutput.end(), '\n'));
+    std::cout << "addOrder one by one: " << sequentialSeconds / orderCount * 1e9 << " ns/order, " << errorCount << " errors" << std::endl;
+
+    for (size_t batchSize : {1, 10, 100, 1'000, 10'000, 100'000}) {
+        std::string output;
+        Portfolio portfolio;
+        double seconds = run([&](Portfolio& p) {
+            for (size_t begin = 0; begin < orders.size(); begin += batchSize) {
+                p.applyOrders(std::span<const Order>(orders).subspan(begin, std::min(batchSize, orders.size() - begin)));
+            }
+        }, output, portfolio);
+
+        bool same = output == expectedOutput && portfolio.getTotalValue() == expected.getTotalValue()
+            && portfolio.getMarketValue() == expected.getMarketValue() && portfolio.getRealizedPnl() == expected.getRealizedPnl()
+            && portfolio.getPositions().size() == expected.getPositions().size();
+        std::cout << "applyOrders, batches of " << batchSize << ": " << seconds / orderCount * 1e9 << " ns/order"
+                  << (same ? " (same positions, totals and errors)" : " (DIFFERENT from addOrder)") << std::endl;
+    }
+}
+
+// Builds a multi-year history (orders spread evenly over yearCount years, in date order) and compares
+// index queries with scanning the whole journal: orders of one symbol in a 30 day window, and one symbol's
+// daily volume over a year.
+void runHistoryBenchmark(size_t orderCount, size_t symbolCount, int yearCount) {
+    std::vector<SymbolId> tickers;
+    for (size_t i = 0; i < symbolCount; ++i) {
+        tickers.push_back(globalSymbols().intern("SYM" + std::to_string(i)));
+    }
+    const Date first(1, 1, 2020);
+    const int32_t dayCount = Date(1, 1, 2020 + yearCount).days() - first.days();
+
+    // generated on the fly: a vector of 50M orders next to the journal would double the memory
+    std::mt19937 eng(42); // fixed seed for reproducibility
+    std::uniform_int_distribution<size_t> symbolDistr(0, symbolCount - 1);
+    std::uniform_int_distribution<int> quantityDistr(1, 100);
+    std::uniform_int_distribution<int> priceDistr(10, 500);
+    std::uniform_int_distribution<int> percentDistr(0, 99);
+    std::vector<Quantity> held(symbolCount);
+    Portfolio portfolio;
+    double ingestSeconds = timeSeconds([&] {
+        for (size_t i = 0; i < orderCount; ++i) {
+            size_t symbol = symbolDistr(eng);
+            Date date = Date::fromDays(first.days() + static_cast<int32_t>(static_cast<double>(i) / orderCount * dayCount));
+            Quantity quantity(quantityDistr(eng));
+            OrderType type = OrderType::BUY;
+            if (held[symbol] > Quantity() && percentDistr(eng) < 40) {
+                quantity = std::min(held[symbol], quantity);
+                type = OrderType::SELL;
+                held[symbol] -= quantity;
+            } else {
+                held[symbol] += quantity;
+            }
+            portfolio.addOrder({tickers[symbol], Price(priceDistr(eng)), quantity, type, date});
+        }
+    });
+    // the first query brings the index up to date with everything ingested so far
+    double buildSeconds = timeSeconds([&] { portfolio.getDailyVolume(tickers[0], first, first); });
+    std::cout << orderCount << " orders over " << symbolCount << " symbols and " << dayCount << " days, ingested at "
+              << ingestSeconds / orderCount * 1e9 << " ns/order, indexed by the first query at "
+              << buildSeconds / orderCount * 1e9 << " ns/order, index size " << portfolio.historyIndexBytes() / 1e6
+              << " MB, peak RSS " << peakResidentMemoryMb() << " MB" << std::endl;
+
+    struct Query {
+        SymbolId symbol;
+        Date from;
+        Date to;
+    };
+    auto randomQueries = [&](size_t count, int32_t length) {
+        std::uniform_int_distribution<int32_t> startDistr(0, dayCount - length);
+        std::vector<Query> queries;
+        for (size_t i = 0; i < count; ++i) {
+            Date from = Date::fromDays(first.days() + startDistr(eng));
+            queries.push_back({tickers[symbolDistr(eng)], from, Date::fromDays(from.days() + length - 1)});
+        }
+        return queries;
+    };
+
+    // orders of a symbol in a 30 day window
+    std::vector<Query> orderQueries = randomQueries(100'000, 30);
+    size_t matches = 0;
+    Quantity matchedQuantity;
+    double indexSeconds = timeSeconds([&] {
+        for (const Query &query : orderQueries) {
+            portfolio.forEachOrder(query.symbol, query.from, query.to, [&](const Order &order) {
+                matches++;
+                matchedQuantity += order.quantity;
+            });
+        }
+    });
+    std::cout << "Orders in 30 days, index: " << indexSeconds / orderQueries.size() * 1e6 << " us/query, "
+              << static_cast<double>(matches) / orderQueries.size() << " matches/query" << std::endl;
+
+    // the same first few queries by scanning every order, to compare and to check the index
+    const size_t scanned = 3;
+    bool same = true;
+    double scanSeconds = timeSeconds([&] {
+        for (size_t q = 0; q < scanned; ++q) {
+            const Query &query = orderQueries[q];
+            size_t scanMatches = 0, indexMatches = 0;
+            for (const Order &order : portfolio.orderHistory()) {
+                if (order.symbol == query.symbol && query.from <= order.date && order.date <= query.to) {
+                    scanMatches++;
+                }
+            }
+            portfolio.forEachOrder(query.symbol, query.from, query.to, [&](const Order&) { indexMatches++; });
+            same = same && scanMatches == indexMatches;
+        }
+    });
+    std::cout << "Orders in 30 days, full scan: " << scanSeconds / scanned * 1e3 << " ms/query ("
+              << (same ? "same results as the index" : "DIFFERENT from the index") << ")" << std::endl;
+
+    // daily volume of a symbol over a year
+    std::vector<Query> volumeQueries = randomQueries(100'000, 365);
+    Quantity volume;
+    size_t days = 0;
+    double volumeSeconds = timeSeconds([&] {
+        for (const Query &query : volumeQueries) {
+            for (const DailyVolume &day : portfolio.getDailyVolume(query.symbol, query.from, query.to)) {
+                volume += day.bought + day.sold;
+                days++;
+            }
+        }
+    });
+    std::cout << "Daily volume over a year, index: " << volumeSeconds / volumeQueries.size() * 1e6 << " us/query, "
+              << static_cast<double>(days) / volumeQueries.size() << " days/query" << std::endl;
+
+    const Query &check = volumeQueries.front();
+    Quantity scanVolume, indexVolume;
+    double volumeScanSeconds = timeSeconds([&] {
+        for (const Order &order : portfolio.orderHistory()) {
+            if (order.symbol == check.symbol && check.from <= order.date && order.date <= check.to) {
+                scanVolume += order.quantity; // every generated order is valid, so every one was filled
+            }
+        }
+    });
+    for (const DailyVolume &day : portfolio.getDailyVolume(check.symbol, check.from, check.to)) {
+        indexVolume += day.bought + day.sold;
+    }
+    std::cout << "Daily volume over a year, full scan: " << volumeScanSeconds * 1e3 << " ms/query ("
+              << (scanVolume == indexVolume ? "same total as the index" : "DIFFERENT from the index") << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    // "bench [orders] [symbols]" runs the order throughput benchmark instead of the demo
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        runOrderBenchmark(argc > 2 ? std::stoul(argv[2]) : 2'000'000, argc > 3 ? std::stoul(argv[3]) : 5'000);
+        return 0;
+    }
+    // "bench-journal [orders]" compares order history storage (allocation counts need -DCOUNT_ALLOCATIONS)
+    if (argc > 1 && std::string(argv[1]) == "bench-journal") {
+        runJournalBenchmark(argc > 2 ? std::stoul(argv[2]) : 20'000'000);
+        return 0;
+    }
+    // "bench-wal [orders]" measures the write-ahead journal and crash recovery
+    if (argc > 1 && std::string(argv[1]) == "bench-wal") {
+        runPersistenceBenchmark(argc > 2 ? std::stoul(argv[2]) : 5'000'000);
+        return 0;
+    }
+    // "bench-ticks [ticks] [symbols]" measures mark-to-market valuation
+    if (argc > 1 && std::string(argv[1]) == "bench-ticks") {
+        runValuationBenchmark(argc > 2 ? std::stoul(argv[2]) : 20'000'000, argc > 3 ? std::stoul(argv[3]) : 5'000);
+        return 0;
+    }
+    // "bench-pipeline [orders] [paced orders/s]" measures multi-threaded order ingestion
+    if (argc > 1 && std::string(argv[1]) == "bench-pipeline") {
+        runPipelineBenchmark(argc > 2 ? std::stoul(argv[2]) : 2'000'000, argc > 3 ? std::stod(argv[3]) : 100'000);
+        return 0;
+    }
+    // "bench-fixed [updates]" compares fixed-point and double position arithmetic
+    if (argc > 1 && std::string(argv[1]) == "bench-fixed") {
+        runFixedPointBenchmark(argc > 2 ? std::stoul(argv[2]) : 100'000'000);
+        return 0;
+    }
+    // "bench-batch [orders] [symbols]" compares batched and one-by-one order application
+    if (argc > 1 && std::string(argv[1]) == "bench-batch") {
+        runBatchBenchmark(argc > 2 ? std::stoul(argv[2]) : 2'000'000, argc > 3 ? std::stoul(argv[3]) : 5'000);
+        return 0;
+    }
+    // "bench-history [orders] [symbols] [years]" measures date range queries over the order history
+    if (argc > 1 && std::string(argv[1]) == "bench-history") {
+        runHistoryBenchmark(argc > 2 ? std::stoul(argv[2]) : 50'000'000, argc > 3 ? std::stoul(argv[3]) : 5'000,
+                            argc > 4 ? std::stoi(argv[4]) : 5);
+        return 0;
+    }
+    // "bench-book [events] [symbols]" reports order book latency percentiles
+    if (argc > 1 && std::string(argv[1]) == "bench-book") {
+        runOrderBookBenchmark(argc > 2 ? std::stoul(argv[2]) : 2'000'000, argc > 3 ? std::stoul(argv[3]) : 100);
+        return 0;
+    }
+
+    Portfolio myPortfolio;
+
+    myPortfolio.addOrder({globalSymbols().intern("AAPL"), Price(150), Quantity(10), OrderType::BUY, {1, 1, 2025}});
+    myPortfolio.addOrder({globalSymbols().intern("AAPL"), Price(160), Quantity(10), OrderType::BUY, {2, 1, 2025}});
+
+    myPortfolio.printPositions();
+
+    myPortfolio.addOrder({globalSymbols().intern("AAPL"), Price(155), Quantity(20), OrderType::SELL, {3, 1, 2025}});
+    myPortfolio.addOrder({globalSymbols().intern("GOOGL"), Price(2800), Quantity(5), OrderType::BUY, {4, 1, 2025}});
 
     myPortfolio.printPositions();
     std::cout << "Total Portfolio Value: " << myPortfolio.getTotalValue() << std::endl;
+
+    // market prices move, the position is marked to them
+    myPortfolio.updatePrice(globalSymbols().intern("GOOGL"), Price(2900));
+    std::cout << "Market Value: " << myPortfolio.getMarketValue()
+              << ", Unrealized P&L: " << myPortfolio.getUnrealizedPnl()
+              << ", Realized P&L: " << myPortfolio.getRealizedPnl() << std::endl;
     myPortfolio.printOrders();
+    myPortfolio.printOrders(globalSymbols().intern("AAPL"), {1, 1, 2025}, {2, 1, 2025});
+
+    // the same orders can also go through a matching engine, where they trade against each other
+    std::cout << "Order book:" << std::endl;
+    MatchingEngine engine([](const Trade &trade) {
+        std::cout << "Trade: " << globalSymbols().name(trade.symbol) << " " << trade.quantity << " @ " << trade.price
+                  << " (order " << trade.incomingOrderId << " " << (trade.incomingType == OrderType::BUY ? "bought from" : "sold to")
+                  << " order " << trade.restingOrderId << ")" << std::endl;
+    });
+    SymbolId aapl = globalSymbols().intern("AAPL");
+    engine.submit({aapl, Price(150), Quantity(10), OrderType::SELL, {1, 1, 2025}});
+    engine.submit({aapl, Price(151), Quantity(10), OrderType::SELL, {1, 1, 2025}});
+    engine.submit({aapl, Price(151), Quantity(15), OrderType::BUY, {2, 1, 2025}}); // takes all of order 1 and half of order 2
+    auto printPrice = [](const std::optional<Price> &price) {
+        if (price) std::cout << *price; else std::cout << "none";
+    };
+    std::cout << "Best bid: ";
+    printPrice(engine.book(aapl).bestBid());
+    std::cout << ", best ask: ";
+    printPrice(engine.book(aapl).bestAsk());
+    std::cout << std::endl;
 
     return 0;
 }
\ No newline at end of file
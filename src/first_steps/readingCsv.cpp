@@ -1,7 +1,52 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <charconv>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <stdexcept>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+#include <limits>
+#include <new>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HAS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2/SSE instructions inside functions that opt in with a target attribute,
+// which lets one binary carry every kernel and pick one at runtime. MSVC always allows the intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_ATTRIBUTE(isa) __attribute__((target(isa)))
+#else
+#define TARGET_ATTRIBUTE(isa)
+#endif
+
+#include "symbol_table.hpp"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 std::vector<std::string> readCsv(const std::string& filename) {
     try {
@@ -33,7 +78,7 @@ std::vector<std::string> readCsv(const std::string& filename) {
 
 // define Ticker struct
 struct Ticker {
-    std::string symbol;
+    SymbolId symbol;
     double price;
     int volume;
     float peRatio;
@@ -58,7 +103,7 @@ std::vector<Ticker> parseVectorOfTickers(const std::vector<std::string> &lines)
         
         try {
             // finds a substring from 0 to first comma
-            ticker.symbol = line.substr(pos, commaPos - pos);
+            ticker.symbol = globalSymbols().intern(line.substr(pos, commaPos - pos));
             // updates position to character after comma
             pos = commaPos + 1;
             // finds next comma
@@ -85,10 +130,1632 @@ std::vector<Ticker> parseVectorOfTickers(const std::vector<std::string> &lines)
 }
 
 
-int main() {
-    std::vector<Ticker> tickers = parseVectorOfTickers(readCsv("data/tickers.csv"));
+
+// --- Memory-mapped ingestion ---
+// readCsv + parseVectorOfTickers copy every line into its own std::string and then substr every field,
+// so a row costs several heap allocations and the file sits in memory twice.
+// The functions below map the file into our address space instead and parse fields as string_view slices of it.
+
+// Read-only memory mapping of a whole file.
+// The OS loads pages lazily as we touch them, nothing is copied into our own buffers.
+// view() is valid for as long as the MappedFile object lives.
+class MappedFile {
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+#if defined(_WIN32)
+        HANDLE file_ = INVALID_HANDLE_VALUE;
+        HANDLE mapping_ = nullptr;
+#endif
+
+    public:
+        explicit MappedFile(const std::string& filename) {
+#if defined(_WIN32)
+            this->file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (this->file_ == INVALID_HANDLE_VALUE) {
+                throw std::runtime_error("Error opening file: " + filename);
+            }
+            LARGE_INTEGER fileSize;
+            GetFileSizeEx(this->file_, &fileSize);
+            this->size_ = static_cast<size_t>(fileSize.QuadPart);
+            if (this->size_ == 0) {
+                return; // mapping an empty file is an error on Windows, an empty view is all we need
+            }
+            this->mapping_ = CreateFileMappingA(this->file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (this->mapping_ == nullptr) {
+                CloseHandle(this->file_);
+                throw std::runtime_error("Error mapping file: " + filename);
+            }
+            this->data_ = static_cast<const char*>(MapViewOfFile(this->mapping_, FILE_MAP_READ, 0, 0, 0));
+            if (this->data_ == nullptr) {
+                CloseHandle(this->mapping_);
+                CloseHandle(this->file_);
+                throw std::runtime_error("Error mapping file: " + filename);
+            }
+#else
+            int fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Error opening file: " + filename);
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                throw std::runtime_error("Error reading file size: " + filename);
+            }
+            this->size_ = static_cast<size_t>(st.st_size);
+            if (this->size_ == 0) {
+                close(fd);
+                return; // mmap rejects zero length, an empty view is all we need
+            }
+            void* mapped = mmap(nullptr, this->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            // the mapping keeps its own reference to the file, so the descriptor can be closed right away
+            close(fd);
+            if (mapped == MAP_FAILED) {
+                throw std::runtime_error("Error mapping file: " + filename);
+            }
+            // we read the file front to back, tell the kernel so it can read ahead aggressively
+            madvise(mapped, this->size_, MADV_SEQUENTIAL);
+            this->data_ = static_cast<const char*>(mapped);
+#endif
+        }
+
+        // the mapping is a unique resource, copying would unmap it twice
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile() {
+#if defined(_WIN32)
+            if (this->data_ != nullptr) UnmapViewOfFile(this->data_);
+            if (this->mapping_ != nullptr) CloseHandle(this->mapping_);
+            if (this->file_ != INVALID_HANDLE_VALUE) CloseHandle(this->file_);
+#else
+            if (this->data_ != nullptr) munmap(const_cast<char*>(this->data_), this->size_);
+#endif
+        }
+
+        std::string_view view() const {
+            return std::string_view(this->data_, this->size_);
+        }
+};
+
+// Same fields as Ticker, but the symbol points into the mapped file instead of owning a copy.
+// Only valid while the MappedFile it came from is alive.
+struct TickerView {
+    std::string_view symbol;
+    double price;
+    int volume;
+    float peRatio;
+};
+
+// from_chars never allocates, never throws and ignores the locale, unlike stod/stoi/stof.
+// We require the whole field to be consumed, so "12abc" is rejected instead of silently read as 12.
+template <typename T>
+bool parseNumber(std::string_view field, T& value) {
+    const char* end = field.data() + field.size();
+    auto [ptr, ec] = std::from_chars(field.data(), end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+// Converts the split fields of one "symbol,price,volume,peRatio" row.
+// Returns nullptr on success, otherwise a short description of what went wrong.
+const char* parseTickerFields(const std::string_view* fields, size_t fieldCount, TickerView& ticker) {
+    if (fieldCount < 2) return "missing price field";
+    if (fieldCount < 3) return "missing volume field";
+    if (fieldCount < 4) return "missing peRatio field";
+
+    std::string_view peRatio = fields[3];
+    // files written on Windows end lines with \r\n
+    if (!peRatio.empty() && peRatio.back() == '\r') {
+        peRatio.remove_suffix(1);
+    }
+
+    ticker.symbol = fields[0];
+    if (!parseNumber(fields[1], ticker.price)) return "invalid price";
+    if (!parseNumber(fields[2], ticker.volume)) return "invalid volume";
+    if (!parseNumber(peRatio, ticker.peRatio)) return "invalid peRatio";
+    return nullptr;
+}
+
+// Parses one row on its own, splitting it with find().
+// Anything after the third comma stays in the peRatio field, so extra columns are reported as an invalid peRatio.
+const char* parseTickerLine(std::string_view line, TickerView& ticker) {
+    std::string_view fields[4];
+    size_t fieldCount = 0;
+
+    size_t commaPos = line.find(',');
+    while (commaPos != std::string_view::npos && fieldCount < 3) {
+        fields[fieldCount++] = line.substr(0, commaPos);
+        line.remove_prefix(commaPos + 1);
+        commaPos = line.find(',');
+    }
+    fields[fieldCount++] = line;
+    return parseTickerFields(fields, fieldCount, ticker);
+}
+
+
+// --- SIMD delimiter scanning ---
+// Calling find() per field restarts a search every few bytes. Instead the kernels below compare a whole
+// 64-byte block against ',' and '\n' at once and return a bitmask with bit i set when block[i] is a delimiter.
+// The tokenizer then walks the set bits, so the cost per byte is a fraction of an instruction.
+
+using DelimiterKernel = uint64_t (*)(const char* block);
+
+// Portable fallback working on 8 bytes at a time inside a normal 64-bit register ("SWAR").
+// Returns 0x80 in every byte of word that is zero and 0x00 elsewhere, without false positives.
+uint64_t zeroBytes(uint64_t word) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    return ~(((word & low7) + low7) | word | low7);
+}
+
+uint64_t delimiterMaskScalar(const char* block) {
+    const uint64_t commas = 0x2C2C2C2C2C2C2C2CULL;   // ',' in every byte
+    const uint64_t newlines = 0x0A0A0A0A0A0A0A0AULL; // '\n' in every byte
+    uint64_t mask = 0;
+    for (int i = 0; i < 8; ++i) {
+        uint64_t word;
+        std::memcpy(&word, block + 8 * i, 8); // memcpy is the well-defined way to do an unaligned load
+        // xor turns matching bytes into zero bytes
+        uint64_t matches = zeroBytes(word ^ commas) | zeroBytes(word ^ newlines);
+        // gather the top bit of each byte into the top byte of the product (assumes little-endian byte order)
+        uint64_t packed = ((matches >> 7) * 0x0102040810204080ULL) >> 56;
+        mask |= packed << (8 * i);
+    }
+    return mask;
+}
+
+#if defined(HAS_X86_SIMD)
+// 4 x 16 bytes. cmpeq produces 0xFF for every matching byte, movemask packs the top bit of each byte into an int.
+TARGET_ATTRIBUTE("sse4.2")
+uint64_t delimiterMaskSse42(const char* block) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, newline));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(matches))) << (16 * i);
+    }
+    return mask;
+}
+
+// 2 x 32 bytes, same idea with 256-bit registers.
+TARGET_ATTRIBUTE("avx2")
+uint64_t delimiterMaskAvx2(const char* block) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    __m256i lowMatches = _mm256_or_si256(_mm256_cmpeq_epi8(low, comma), _mm256_cmpeq_epi8(low, newline));
+    __m256i highMatches = _mm256_or_si256(_mm256_cmpeq_epi8(high, comma), _mm256_cmpeq_epi8(high, newline));
+    return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(lowMatches)))
+         | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(highMatches))) << 32;
+}
+
+bool cpuSupports(const char* isa) {
+#if defined(__GNUC__) || defined(__clang__)
+    return std::string_view(isa) == "avx2" ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("sse4.2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    if (std::string_view(isa) == "sse4.2") {
+        return (info[2] & (1 << 20)) != 0;
+    }
+    // AVX2 also needs the OS to save the wide registers on context switch (OSXSAVE + XCR0 bits)
+    bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+#endif
+
+struct DelimiterKernelInfo {
+    const char* name;
+    DelimiterKernel kernel;
+};
+
+// Every kernel this CPU can run, slowest first.
+std::vector<DelimiterKernelInfo> availableDelimiterKernels() {
+    std::vector<DelimiterKernelInfo> kernels = {{"scalar", delimiterMaskScalar}};
+#if defined(HAS_X86_SIMD)
+    if (cpuSupports("sse4.2")) kernels.push_back({"sse4.2", delimiterMaskSse42});
+    if (cpuSupports("avx2")) kernels.push_back({"avx2", delimiterMaskAvx2});
+#endif
+    return kernels;
+}
+
+// Feature detection runs once, on first use.
+DelimiterKernel bestDelimiterKernel() {
+    static const DelimiterKernel best = availableDelimiterKernels().back().kernel;
+    return best;
+}
+
+// Splits data into lines and fields and calls onLine(fields, fieldCount, lineIndex) for every non-blank line.
+// At most 4 fields are split, anything after the third comma stays in the last one, the same as parseTickerLine.
+// lineIndex counts from 0 at the start of data. Returns the number of lines seen, blank ones included.
+template <typename OnLine>
+size_t tokenizeLines(std::string_view data, DelimiterKernel kernel, OnLine&& onLine) {
+    constexpr size_t maxFields = 4;
+    std::string_view fields[maxFields];
+    size_t fieldCount = 0;
+    size_t fieldStart = 0;
+    size_t lineIndex = 0;
+    const char* base = data.data();
+
+    auto finishLine = [&](size_t lineEnd) {
+        std::string_view last(base + fieldStart, lineEnd - fieldStart);
+        // skip blank lines
+        if (fieldCount > 0 || (!last.empty() && last != "\r")) {
+            fields[fieldCount++] = last;
+            onLine(static_cast<const std::string_view*>(fields), fieldCount, lineIndex);
+        }
+        lineIndex++;
+        fieldCount = 0;
+        fieldStart = lineEnd + 1;
+    };
+
+    auto walkMask = [&](size_t blockStart, uint64_t mask) {
+        while (mask != 0) {
+            size_t pos = blockStart + static_cast<size_t>(std::countr_zero(mask));
+            mask &= mask - 1; // clear lowest set bit
+            if (base[pos] == '\n') {
+                finishLine(pos);
+            } else if (fieldCount < maxFields - 1) {
+                fields[fieldCount++] = std::string_view(base + fieldStart, pos - fieldStart);
+                fieldStart = pos + 1;
+            }
+        }
+    };
+
+    size_t blockStart = 0;
+    for (; blockStart + 64 <= data.size(); blockStart += 64) {
+        walkMask(blockStart, kernel(base + blockStart));
+    }
+    // the last partial block is copied into a zero padded buffer so the kernel never reads past the mapping
+    if (blockStart < data.size()) {
+        char tail[64] = {};
+        std::memcpy(tail, base + blockStart, data.size() - blockStart);
+        walkMask(blockStart, kernel(tail));
+    }
+    // last line without trailing newline
+    if (fieldStart < data.size() || fieldCount > 0) {
+        finishLine(data.size());
+    }
+    return lineIndex;
+}
+
+// Walks every line of data and calls onTicker(const TickerView&) for valid rows and onError(lineIndex, message) for bad ones.
+// lineIndex counts from 0 at the start of data, so callers working on a slice of a file can shift it to a real line number.
+// Returns the number of lines seen, blank ones included.
+template <typename OnTicker, typename OnError>
+size_t scanTickerLines(std::string_view data, OnTicker&& onTicker, OnError&& onError) {
+    return tokenizeLines(data, bestDelimiterKernel(), [&](const std::string_view* fields, size_t fieldCount, size_t lineIndex) {
+        TickerView ticker;
+        if (const char* error = parseTickerFields(fields, fieldCount, ticker)) {
+            onError(lineIndex, error);
+        } else {
+            onTicker(ticker);
+        }
+    });
+}
+
+// Everything after the header line.
+std::string_view skipHeader(std::string_view data) {
+    size_t newlinePos = data.find('\n');
+    return newlinePos == std::string_view::npos ? std::string_view() : data.substr(newlinePos + 1);
+}
+
+// Calls onTicker(const TickerView&) for every valid row of a CSV held in memory, skipping the header.
+// Nothing is allocated per row, so this is the path to use when the rows are aggregated rather than stored.
+template <typename Callback>
+void forEachTicker(std::string_view data, Callback&& onTicker) {
+    scanTickerLines(skipHeader(data), onTicker, [](size_t lineIndex, const char* error) {
+        // + 1 for the header, + 1 because line numbers start at 1
+        std::cerr << "Error parsing line " << lineIndex + 2 << ": " << error << std::endl;
+    });
+}
+
+// Builds Ticker records straight from the mapped bytes.
+// Symbols are interned into ids, so apart from the first sighting of a ticker the only allocation is the result vector itself.
+std::vector<Ticker> parseMappedTickers(std::string_view data) {
+    std::vector<Ticker> tickers;
+    // one cheap pass to count rows lets us allocate the result exactly once
+    tickers.reserve(static_cast<size_t>(std::count(data.begin(), data.end(), '\n')) + 1);
+
+    SymbolCache symbols;
+    forEachTicker(data, [&tickers, &symbols](const TickerView &ticker) {
+        tickers.push_back({symbols.intern(ticker.symbol), ticker.price, ticker.volume, ticker.peRatio});
+    });
+    return tickers;
+}
+
+// --- Parallel parsing ---
+
+// What one worker produces for its slice of the file.
+struct ChunkResult {
+    std::vector<Ticker> tickers;
+    std::vector<std::pair<size_t, const char*>> errors; // (line index inside the chunk, message)
+    size_t lineCount = 0;
+};
+
+// Splits data into roughly equal pieces whose boundaries are moved forward to the next newline,
+// so every row lies entirely inside exactly one chunk.
+std::vector<std::string_view> splitAtNewlines(std::string_view data, size_t chunkCount) {
+    std::vector<std::string_view> chunks;
+    size_t chunkSize = data.size() / chunkCount + 1;
+    size_t begin = 0;
+
+    while (begin < data.size()) {
+        size_t end = std::min(begin + chunkSize, data.size());
+        if (end < data.size()) {
+            size_t newlinePos = data.find('\n', end - 1);
+            end = newlinePos == std::string_view::npos ? data.size() : newlinePos + 1;
+        }
+        chunks.push_back(data.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+// Runs work(index) for every index in [0, count) on threadCount threads.
+// Threads pull the next index from a shared atomic counter, so a slow chunk does not hold up the others.
+template <typename Work>
+void parallelFor(size_t count, size_t threadCount, Work&& work) {
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            work(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker(); // the calling thread works too instead of just waiting
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+// Parallel version of parseMappedTickers: same output order, same error messages and line numbers.
+// threadCount = 0 uses every hardware thread.
+std::vector<Ticker> parseMappedTickersParallel(std::string_view data, size_t threadCount = 0) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threadCount == 1) {
+        return parseMappedTickers(data); // nothing to gain from chunking, and it saves the merge copy
+    }
+
+    // a few chunks per thread keeps the threads busy when some chunks parse slower than others
+    std::vector<std::string_view> chunks = splitAtNewlines(skipHeader(data), threadCount * 4);
+    std::vector<ChunkResult> results(chunks.size());
+
+    parallelFor(chunks.size(), threadCount, [&](size_t i) {
+        ChunkResult &result = results[i];
+        result.tickers.reserve(static_cast<size_t>(std::count(chunks[i].begin(), chunks[i].end(), '\n')) + 1);
+        SymbolCache symbols; // per chunk, so workers only touch the shared symbol table for tickers they have not seen yet
+        result.lineCount = scanTickerLines(chunks[i],
+            [&result, &symbols](const TickerView &ticker) {
+                result.tickers.push_back({symbols.intern(ticker.symbol), ticker.price, ticker.volume, ticker.peRatio});
+            },
+            [&result](size_t lineIndex, const char* error) {
+                result.errors.emplace_back(lineIndex, error);
+            });
+    });
+
+    // a chunk only knows line numbers relative to its own start, the running total of earlier chunks fixes them up
+    std::vector<size_t> firstRow(chunks.size() + 1, 0);
+    size_t firstLine = 2; // line 1 is the header
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        for (const auto &[lineIndex, error] : results[i].errors) {
+            std::cerr << "Error parsing line " << firstLine + lineIndex << ": " << error << std::endl;
+        }
+        firstLine += results[i].lineCount;
+        firstRow[i + 1] = firstRow[i] + results[i].tickers.size();
+    }
+
+    // moving the per-chunk buffers into place is as much memory traffic as parsing, so it runs in parallel too
+    std::vector<Ticker> tickers(firstRow.back());
+    parallelFor(chunks.size(), threadCount, [&](size_t i) {
+        std::move(results[i].tickers.begin(), results[i].tickers.end(), tickers.begin() + firstRow[i]);
+        std::vector<Ticker>().swap(results[i].tickers); // free the chunk buffer as soon as it is copied
+    });
+    return tickers;
+}
+
+// Same contract as parseVectorOfTickers(readCsv(filename)): prints the error and returns an empty vector on failure.
+std::vector<Ticker> readTickersMapped(const std::string& filename) {
+    try {
+        MappedFile file(filename);
+        return parseMappedTickers(file.view());
+    } catch (std::exception &e) {
+        std::cerr << "Exception occurred: " << e.what() << std::endl;
+        return {};
+    }
+}
+
+
+// --- Columnar storage ---
+// std::vector<Ticker> stores whole rows next to each other (array of structs), so a scan over prices
+// also drags every symbol string and volume through the cache. TickerTable keeps one contiguous array per
+// field instead (struct of arrays): a price scan reads only prices, 8 bytes per row instead of 48,
+// and the SIMD kernels below can load 4 prices per instruction.
+
+// Allocator for std::vector that aligns the buffer to a 64-byte cache line,
+// so vector loads never straddle two lines at the start of a column.
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t alignment{64};
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), alignment));
+    }
+    void deallocate(T* ptr, size_t) {
+        ::operator delete(ptr, alignment);
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Column kernels. Each has a plain loop version and an AVX2 version, picked once at runtime like the delimiter kernels.
+struct ColumnKernels {
+    const char* name;
+    double (*sum)(const double* values, size_t n);
+    void (*minMax)(const double* values, size_t n, double& min, double& max);
+    long long (*sumInt32)(const int32_t* values, size_t n);
+    double (*dot)(const double* prices, const int32_t* volumes, size_t n);
+    void (*filterLess)(const float* values, size_t n, float limit, std::vector<uint32_t>& rows);
+};
+
+// Several independent accumulators let the CPU overlap the additions instead of waiting on one long dependency chain.
+double sumScalar(const double* values, size_t n) {
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc[0] += values[i];
+        acc[1] += values[i + 1];
+        acc[2] += values[i + 2];
+        acc[3] += values[i + 3];
+    }
+    for (; i < n; ++i) {
+        acc[0] += values[i];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+void minMaxScalar(const double* values, size_t n, double& min, double& max) {
+    double mins[4], maxs[4];
+    std::fill(mins, mins + 4, std::numeric_limits<double>::infinity());
+    std::fill(maxs, maxs + 4, -std::numeric_limits<double>::infinity());
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            mins[lane] = values[i + lane] < mins[lane] ? values[i + lane] : mins[lane];
+            maxs[lane] = values[i + lane] > maxs[lane] ? values[i + lane] : maxs[lane];
+        }
+    }
+    for (; i < n; ++i) {
+        mins[0] = std::min(mins[0], values[i]);
+        maxs[0] = std::max(maxs[0], values[i]);
+    }
+    min = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+    max = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+}
+
+long long sumInt32Scalar(const int32_t* values, size_t n) {
+    long long sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+double dotScalar(const double* prices, const int32_t* volumes, size_t n) {
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            acc[lane] += prices[i + lane] * volumes[i + lane];
+        }
+    }
+    for (; i < n; ++i) {
+        acc[0] += prices[i] * volumes[i];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+void filterLessScalar(const float* values, size_t n, float limit, std::vector<uint32_t>& rows) {
+    for (size_t i = 0; i < n; ++i) {
+        if (values[i] < limit) {
+            rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+#if defined(HAS_X86_SIMD)
+// Adds the 4 lanes of a register together.
+TARGET_ATTRIBUTE("avx2")
+double horizontalSum(__m256d v) {
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+TARGET_ATTRIBUTE("avx2")
+double sumAvx2(const double* values, size_t n) {
+    // two registers of 4 lanes = 8 independent accumulators
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(values + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(values + i + 4));
+    }
+    double sum = horizontalSum(_mm256_add_pd(acc0, acc1));
+    for (; i < n; ++i) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+TARGET_ATTRIBUTE("avx2")
+void minMaxAvx2(const double* values, size_t n, double& min, double& max) {
+    __m256d vmin = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    __m256d vmax = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(values + i);
+        vmin = _mm256_min_pd(vmin, v);
+        vmax = _mm256_max_pd(vmax, v);
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, vmin);
+    min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm256_store_pd(lanes, vmax);
+    max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < n; ++i) {
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+}
+
+TARGET_ATTRIBUTE("avx2")
+long long sumInt32Avx2(const int32_t* values, size_t n) {
+    // widen 4 ints to 4 64-bit lanes before adding so large volumes cannot overflow
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(v));
+    }
+    alignas(32) long long lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    long long sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; ++i) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+TARGET_ATTRIBUTE("avx2")
+double dotAvx2(const double* prices, const int32_t* volumes, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d v0 = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(volumes + i)));
+        __m256d v1 = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(volumes + i + 4)));
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(prices + i), v0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(prices + i + 4), v1));
+    }
+    double sum = horizontalSum(_mm256_add_pd(acc0, acc1));
+    for (; i < n; ++i) {
+        sum += prices[i] * volumes[i];
+    }
+    return sum;
+}
+
+TARGET_ATTRIBUTE("avx2")
+void filterLessAvx2(const float* values, size_t n, float limit, std::vector<uint32_t>& rows) {
+    const __m256 vlimit = _mm256_set1_ps(limit);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // one bit per lane that passed the comparison, then the same set bit walk as the tokenizer
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), vlimit, _CMP_LT_OQ)));
+        while (mask != 0) {
+            rows.push_back(static_cast<uint32_t>(i + std::countr_zero(mask)));
+            mask &= mask - 1;
+        }
+    }
+    for (; i < n; ++i) {
+        if (values[i] < limit) {
+            rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+#endif
+
+// Every kernel set this CPU can run, slowest first.
+std::vector<ColumnKernels> availableColumnKernels() {
+    std::vector<ColumnKernels> kernels = {{"scalar", sumScalar, minMaxScalar, sumInt32Scalar, dotScalar, filterLessScalar}};
+#if defined(HAS_X86_SIMD)
+    if (cpuSupports("avx2")) {
+        kernels.push_back({"avx2", sumAvx2, minMaxAvx2, sumInt32Avx2, dotAvx2, filterLessAvx2});
+    }
+#endif
+    return kernels;
+}
+
+const ColumnKernels& bestColumnKernels() {
+    static const ColumnKernels best = availableColumnKernels().back();
+    return best;
+}
+
+// Read-only view of ticker columns, wherever they live (a TickerTable in memory or a mapped snapshot file).
+// symbolIds are globalSymbols() ids for a TickerTable and ids into the file's own dictionary for a TickerSnapshot.
+// The aggregates take a kernel set that defaults to the fastest one this CPU supports, passing another is only useful for benchmarks.
+struct TickerColumns {
+    const uint32_t* symbolIds;
+    const double* prices;
+    const int32_t* volumes;
+    const float* peRatios;
+    size_t size;
+
+    double sumPrice(const ColumnKernels& kernels = bestColumnKernels()) const {
+        return kernels.sum(this->prices, this->size);
+    }
+
+    double meanPrice(const ColumnKernels& kernels = bestColumnKernels()) const {
+        return this->size > 0 ? this->sumPrice(kernels) / this->size : 0.0;
+    }
+
+    double minPrice(const ColumnKernels& kernels = bestColumnKernels()) const {
+        double min, max;
+        kernels.minMax(this->prices, this->size, min, max);
+        return min;
+    }
+
+    double maxPrice(const ColumnKernels& kernels = bestColumnKernels()) const {
+        double min, max;
+        kernels.minMax(this->prices, this->size, min, max);
+        return max;
+    }
+
+    long long totalVolume(const ColumnKernels& kernels = bestColumnKernels()) const {
+        return kernels.sumInt32(this->volumes, this->size);
+    }
+
+    // volume weighted average price: sum(price * volume) / sum(volume)
+    double vwap(const ColumnKernels& kernels = bestColumnKernels()) const {
+        long long volume = this->totalVolume(kernels);
+        return volume > 0 ? kernels.dot(this->prices, this->volumes, this->size) / volume : 0.0;
+    }
+
+    // Indices of all rows with peRatio < limit, in row order.
+    std::vector<uint32_t> rowsWithPeRatioBelow(float limit, const ColumnKernels& kernels = bestColumnKernels()) const {
+        std::vector<uint32_t> rows;
+        kernels.filterLess(this->peRatios, this->size, limit, rows);
+        return rows;
+    }
+};
+
+// Ticker data stored column by column.
+class TickerTable {
+    private:
+        SymbolCache symbols_;
+        std::vector<SymbolId> symbolIds_;
+        AlignedVector<double> prices_;
+        AlignedVector<int32_t> volumes_;
+        AlignedVector<float> peRatios_;
+
+    public:
+        // Builds the table straight from CSV bytes, no intermediate Ticker records.
+        static TickerTable fromCsv(std::string_view data) {
+            TickerTable table;
+            table.reserve(static_cast<size_t>(std::count(data.begin(), data.end(), '\n')));
+            forEachTicker(data, [&table](const TickerView &ticker) {
+                table.append(ticker);
+            });
+            return table;
+        }
+
+        void reserve(size_t rows) {
+            this->symbolIds_.reserve(rows);
+            this->prices_.reserve(rows);
+            this->volumes_.reserve(rows);
+            this->peRatios_.reserve(rows);
+        }
+
+        void append(const TickerView &ticker) {
+            this->symbolIds_.push_back(this->symbols_.intern(ticker.symbol));
+            this->prices_.push_back(ticker.price);
+            this->volumes_.push_back(ticker.volume);
+            this->peRatios_.push_back(ticker.peRatio);
+        }
+
+        size_t size() const {
+            return this->prices_.size();
+        }
+
+        TickerView row(size_t index) const {
+            return {globalSymbols().name(this->symbolIds_[index]), this->prices_[index], this->volumes_[index], this->peRatios_[index]};
+        }
+
+        // Pointers stay valid until the next append.
+        TickerColumns columns() const {
+            return {this->symbolIds_.data(), this->prices_.data(), this->volumes_.data(), this->peRatios_.data(), this->size()};
+        }
+};
+
+
+// --- Binary snapshot ---
+// Parsing text on every start is wasted work when the data has not changed. A snapshot stores the TickerTable
+// columns exactly as they sit in memory, so loading one is a single mmap and the columns are used in place.
+//
+// File layout (native byte order, every section starts on a 64-byte boundary):
+//   SnapshotHeader
+//   symbol ids      uint32 x rowCount
+//   prices          double x rowCount
+//   volumes         int32  x rowCount
+//   peRatios        float  x rowCount
+//   symbol offsets  uint32 x (symbolCount + 1), symbol i is bytes [offsets[i], offsets[i + 1])
+//   symbol bytes    all symbol names back to back
+// The checksum covers the whole file: the header (with its checksum field taken as 0) and everything after it.
+
+constexpr char snapshotMagic[8] = {'T', 'I', 'C', 'K', 'S', 'N', 'A', 'P'};
+constexpr uint32_t snapshotVersion = 2; // version 2: the checksum also covers the header
+constexpr uint32_t snapshotByteOrderMark = 0x01020304; // reads back differently on a machine with the other byte order
+constexpr size_t snapshotAlignment = 64;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t headerSize;
+    uint64_t fileSize;
+    uint64_t rowCount;
+    uint64_t symbolCount;
+    uint64_t symbolIdsOffset;
+    uint64_t pricesOffset;
+    uint64_t volumesOffset;
+    uint64_t peRatiosOffset;
+    uint64_t symbolOffsetsOffset;
+    uint64_t symbolBytesOffset;
+    uint64_t symbolBytesSize;
+    uint64_t checksum;
+};
+
+// 64-bit checksum in the style of xxHash64: four independent lanes eat 32 bytes per step with a multiply and a rotate,
+// so it runs at several GB/s while still catching truncated, reordered or flipped bytes.
+// Data can be fed in pieces of any size, the result only depends on the concatenated bytes.
+class Checksum64 {
+    private:
+        static constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+        static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+
+        uint64_t lanes_[4] = {prime1 + prime2, prime2, 0, 0 - prime1};
+        unsigned char pending_[32];
+        size_t pendingSize_ = 0;
+        uint64_t totalSize_ = 0;
+
+        static uint64_t round(uint64_t lane, uint64_t input) {
+            return std::rotl(lane + input * prime2, 31) * prime1;
+        }
+
+        void consumeStripe(const unsigned char* stripe) {
+            for (int i = 0; i < 4; ++i) {
+                uint64_t word;
+                std::memcpy(&word, stripe + 8 * i, 8);
+                this->lanes_[i] = round(this->lanes_[i], word);
+            }
+        }
+
+    public:
+        void update(const void* data, size_t size) {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            this->totalSize_ += size;
+
+            // top up a partially filled stripe first
+            if (this->pendingSize_ > 0) {
+                size_t take = std::min(size, 32 - this->pendingSize_);
+                std::memcpy(this->pending_ + this->pendingSize_, bytes, take);
+                this->pendingSize_ += take;
+                bytes += take;
+                size -= take;
+                if (this->pendingSize_ < 32) {
+                    return;
+                }
+                this->consumeStripe(this->pending_);
+                this->pendingSize_ = 0;
+            }
+            for (; size >= 32; bytes += 32, size -= 32) {
+                this->consumeStripe(bytes);
+            }
+            std::memcpy(this->pending_, bytes, size);
+            this->pendingSize_ = size;
+        }
+
+        uint64_t finish() const {
+            uint64_t hash = std::rotl(this->lanes_[0], 1) + std::rotl(this->lanes_[1], 7) + std::rotl(this->lanes_[2], 12) + std::rotl(this->lanes_[3], 18);
+            hash += this->totalSize_;
+            for (size_t i = 0; i < this->pendingSize_; ++i) {
+                hash = std::rotl(hash ^ (this->pending_[i] * prime1), 11) * prime2;
+            }
+            // final avalanche so every input bit affects every output bit
+            hash ^= hash >> 33;
+            hash *= prime2;
+            hash ^= hash >> 29;
+            return hash;
+        }
+};
+
+// Writes table to filename in the snapshot format. Throws std::runtime_error if the file cannot be written.
+void writeTickerSnapshot(const TickerTable& table, const std::string& filename) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error opening file for writing: " + filename);
+    }
+
+    TickerColumns columns = table.columns();
+
+    // global symbol ids only mean something inside this process, so the file gets its own dense dictionary
+    // holding just the symbols the table uses, numbered in order of first appearance
+    // global ids are dense, so a plain vector indexed by them works as the translation map
+    const uint32_t unseen = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> localIds(globalSymbols().size(), unseen);
+    std::vector<uint32_t> fileSymbolIds(columns.size);
+    std::vector<uint32_t> symbolOffsets = {0};
+    std::string symbolBytes;
+    for (size_t row = 0; row < columns.size; ++row) {
+        uint32_t &localId = localIds[columns.symbolIds[row]];
+        if (localId == unseen) {
+            localId = static_cast<uint32_t>(symbolOffsets.size() - 1);
+            symbolBytes += globalSymbols().name(columns.symbolIds[row]);
+            symbolOffsets.push_back(static_cast<uint32_t>(symbolBytes.size()));
+        }
+        fileSymbolIds[row] = localId;
+    }
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.byteOrderMark = snapshotByteOrderMark;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.rowCount = columns.size;
+    header.symbolCount = symbolOffsets.size() - 1;
+
+    // lay out the sections first so the header can be written before the data
+    uint64_t offset = sizeof(SnapshotHeader);
+    auto place = [&offset](uint64_t bytes) {
+        offset = (offset + snapshotAlignment - 1) / snapshotAlignment * snapshotAlignment;
+        uint64_t start = offset;
+        offset += bytes;
+        return start;
+    };
+    header.symbolIdsOffset = place(columns.size * sizeof(uint32_t));
+    header.pricesOffset = place(columns.size * sizeof(double));
+    header.volumesOffset = place(columns.size * sizeof(int32_t));
+    header.peRatiosOffset = place(columns.size * sizeof(float));
+    header.symbolOffsetsOffset = place(symbolOffsets.size() * sizeof(uint32_t));
+    header.symbolBytesOffset = place(symbolBytes.size());
+    header.symbolBytesSize = symbolBytes.size();
+    header.fileSize = offset;
+
+    // the checksum is computed on the fly from the same bytes, padding included
+    Checksum64 checksum;
+    uint64_t written = sizeof(SnapshotHeader);
+    auto writeSection = [&](uint64_t sectionOffset, const void* data, size_t bytes) {
+        static const char zeros[snapshotAlignment] = {};
+        checksum.update(zeros, sectionOffset - written);
+        checksum.update(data, bytes);
+        file.write(zeros, static_cast<std::streamsize>(sectionOffset - written));
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        written = sectionOffset + bytes;
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // checksum is patched in at the end
+    checksum.update(&header, sizeof(header));                             // with the checksum field still 0
+    writeSection(header.symbolIdsOffset, fileSymbolIds.data(), columns.size * sizeof(uint32_t));
+    writeSection(header.pricesOffset, columns.prices, columns.size * sizeof(double));
+    writeSection(header.volumesOffset, columns.volumes, columns.size * sizeof(int32_t));
+    writeSection(header.peRatiosOffset, columns.peRatios, columns.size * sizeof(float));
+    writeSection(header.symbolOffsetsOffset, symbolOffsets.data(), symbolOffsets.size() * sizeof(uint32_t));
+    writeSection(header.symbolBytesOffset, symbolBytes.data(), symbolBytes.size());
+
+    header.checksum = checksum.finish();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!file) {
+        throw std::runtime_error("Error writing file: " + filename);
+    }
+}
+
+// A snapshot file mapped into memory. Columns point straight into the mapping, nothing is parsed or copied.
+// The constructor throws std::runtime_error if the file is not a valid snapshot.
+class TickerSnapshot {
+    private:
+        MappedFile file_;
+        SnapshotHeader header_;
+        const uint32_t* symbolOffsets_ = nullptr;
+        const char* symbolBytes_ = nullptr;
+        std::vector<SymbolId> globalIds_; // file dictionary id -> globalSymbols() id
+
+        template <typename T>
+        const T* section(uint64_t offset) const {
+            return reinterpret_cast<const T*>(this->file_.view().data() + offset);
+        }
+
+        // true when [offset, offset + count * elementSize) lies inside the file and starts aligned
+        bool sectionFits(uint64_t offset, uint64_t count, uint64_t elementSize) const {
+            uint64_t size = this->file_.view().size();
+            return offset % snapshotAlignment == 0 && offset <= size && count <= (size - offset) / elementSize;
+        }
+
+    public:
+        // verifyChecksum reads the whole file once, pass false to trust the file and only touch the pages actually used
+        explicit TickerSnapshot(const std::string& filename, bool verifyChecksum = true) : file_(filename) {
+            std::string_view data = this->file_.view();
+            if (data.size() < sizeof(SnapshotHeader)) {
+                throw std::runtime_error("Not a ticker snapshot (file too small): " + filename);
+            }
+            std::memcpy(&this->header_, data.data(), sizeof(SnapshotHeader));
+            const SnapshotHeader& h = this->header_;
+
+            if (std::memcmp(h.magic, snapshotMagic, sizeof(snapshotMagic)) != 0) {
+                throw std::runtime_error("Not a ticker snapshot (bad magic): " + filename);
+            }
+            if (h.byteOrderMark != snapshotByteOrderMark) {
+                throw std::runtime_error("Ticker snapshot was written on a machine with a different byte order: " + filename);
+            }
+            if (h.version != snapshotVersion || h.headerSize != sizeof(SnapshotHeader)) {
+                throw std::runtime_error("Unsupported ticker snapshot version " + std::to_string(h.version) + ": " + filename);
+            }
+            // symbol ids are 32-bit, and symbolCount + 1 below must not wrap around
+            if (h.symbolCount >= std::numeric_limits<uint32_t>::max()) {
+                throw std::runtime_error("Ticker snapshot is truncated or corrupt: " + filename);
+            }
+            if (h.fileSize != data.size()
+                || !this->sectionFits(h.symbolIdsOffset, h.rowCount, sizeof(uint32_t))
+                || !this->sectionFits(h.pricesOffset, h.rowCount, sizeof(double))
+                || !this->sectionFits(h.volumesOffset, h.rowCount, sizeof(int32_t))
+                || !this->sectionFits(h.peRatiosOffset, h.rowCount, sizeof(float))
+                || !this->sectionFits(h.symbolOffsetsOffset, h.symbolCount + 1, sizeof(uint32_t))
+                || !this->sectionFits(h.symbolBytesOffset, h.symbolBytesSize, 1)) {
+                throw std::runtime_error("Ticker snapshot is truncated or corrupt: " + filename);
+            }
+            if (verifyChecksum) {
+                Checksum64 checksum;
+                SnapshotHeader unsummed = h;
+                unsummed.checksum = 0; // the value it was computed with
+                checksum.update(&unsummed, sizeof(unsummed));
+                checksum.update(data.data() + sizeof(SnapshotHeader), data.size() - sizeof(SnapshotHeader));
+                if (checksum.finish() != h.checksum) {
+                    throw std::runtime_error("Ticker snapshot checksum mismatch: " + filename);
+                }
+            }
+
+            this->symbolOffsets_ = this->section<uint32_t>(h.symbolOffsetsOffset);
+            this->symbolBytes_ = this->section<char>(h.symbolBytesOffset);
+            // the dictionary is tiny, checking it here means symbolName never reads outside the file
+            for (uint64_t i = 0; i < h.symbolCount; ++i) {
+                if (this->symbolOffsets_[i] > this->symbolOffsets_[i + 1] || this->symbolOffsets_[i + 1] > h.symbolBytesSize) {
+                    throw std::runtime_error("Ticker snapshot has a corrupt symbol dictionary: " + filename);
+                }
+            }
+            for (uint32_t id = 0; id < h.symbolCount; ++id) {
+                this->globalIds_.push_back(globalSymbols().intern(this->symbolName(id)));
+            }
+        }
+
+        size_t size() const {
+            return this->header_.rowCount;
+        }
+
+        size_t symbolCount() const {
+            return this->header_.symbolCount;
+        }
+
+        std::string_view symbolName(uint32_t id) const {
+            if (id >= this->header_.symbolCount) {
+                throw std::out_of_range("Symbol id out of range");
+            }
+            return std::string_view(this->symbolBytes_ + this->symbolOffsets_[id], this->symbolOffsets_[id + 1] - this->symbolOffsets_[id]);
+        }
+
+        // Translates a symbol id of columns().symbolIds into the id the rest of the program uses.
+        SymbolId globalSymbolId(uint32_t id) const {
+            return this->globalIds_.at(id);
+        }
+
+        TickerColumns columns() const {
+            return {this->section<uint32_t>(this->header_.symbolIdsOffset), this->section<double>(this->header_.pricesOffset),
+                    this->section<int32_t>(this->header_.volumesOffset), this->section<float>(this->header_.peRatiosOffset), this->size()};
+        }
+
+        TickerView row(size_t index) const {
+            TickerColumns c = this->columns();
+            return {this->symbolName(c.symbolIds[index]), c.prices[index], c.volumes[index], c.peRatios[index]};
+        }
+};
+
+
+// --- Streaming ---
+// Everything above needs the whole file addressable at once. TickerStreamReader instead reads through one fixed-size
+// buffer that is reused for the whole file, so memory stays constant no matter how big the input is, and it works
+// on pipes and stdin, which cannot be mapped. It is pull based: nothing is read until the consumer asks for the
+// next row, so a slow consumer automatically slows the reading down instead of letting data pile up.
+
+class TickerStreamReader {
+    private:
+        std::FILE* file_;
+        bool ownsFile_;
+        std::vector<char> buffer_;
+        size_t begin_ = 0; // unread bytes are [begin_, end_)
+        size_t end_ = 0;
+        bool eof_ = false;
+        bool skippingLongLine_ = false;
+        size_t linesSeen_ = 0;
+
+        // rows parsed from the complete lines currently in the buffer, handed out one by one by next()
+        std::vector<TickerView> pending_;
+        size_t pendingIndex_ = 0;
+
+        // Parses the complete lines in buffer_[0, length) into pending_.
+        void tokenize(size_t length) {
+            std::string_view data(this->buffer_.data(), length);
+            if (this->linesSeen_ == 0) {
+                data = skipHeader(data);
+                this->linesSeen_ = 1;
+            }
+            size_t firstLine = this->linesSeen_ + 1;
+            this->linesSeen_ += scanTickerLines(data,
+                [this](const TickerView &ticker) {
+                    this->pending_.push_back(ticker);
+                },
+                [firstLine](size_t lineIndex, const char* error) {
+                    std::cerr << "Error parsing line " << firstLine + lineIndex << ": " << error << std::endl;
+                });
+        }
+
+        // Reads more input and parses whatever complete lines it finished.
+        // Returns false once the input is exhausted.
+        bool refill() {
+            this->pending_.clear();
+            this->pendingIndex_ = 0;
+
+            // the rows handed out so far point into the buffer, they are only invalidated now that the consumer asked for more
+            std::memmove(this->buffer_.data(), this->buffer_.data() + this->begin_, this->end_ - this->begin_);
+            this->end_ -= this->begin_;
+            this->begin_ = 0;
+
+            if (this->eof_) {
+                if (this->end_ == 0) {
+                    return false;
+                }
+                if (!this->skippingLongLine_) {
+                    this->tokenize(this->end_); // last line without trailing newline
+                }
+                this->end_ = 0;
+                return true;
+            }
+
+            size_t bytesRead = std::fread(this->buffer_.data() + this->end_, 1, this->buffer_.size() - this->end_, this->file_);
+            if (bytesRead == 0) {
+                if (std::ferror(this->file_)) {
+                    throw std::runtime_error("Error reading ticker stream");
+                }
+                this->eof_ = true;
+                return true;
+            }
+            size_t scanFrom = this->end_;
+            this->end_ += bytesRead;
+
+            std::string_view data(this->buffer_.data(), this->end_);
+            if (this->skippingLongLine_) {
+                size_t newlinePos = data.find('\n', scanFrom);
+                if (newlinePos == std::string_view::npos) {
+                    this->end_ = 0; // still inside the long line, drop it all
+                    return true;
+                }
+                this->skippingLongLine_ = false;
+                this->begin_ = newlinePos + 1;
+                return true;
+            }
+
+            size_t lastNewline = data.rfind('\n');
+            if (lastNewline == std::string_view::npos) {
+                if (this->end_ == this->buffer_.size()) {
+                    // a row that does not fit into the buffer can never be completed, report it and skip to the next newline
+                    std::cerr << "Error parsing line " << this->linesSeen_ + 1 << ": line longer than the "
+                              << this->buffer_.size() << " byte read buffer" << std::endl;
+                    this->linesSeen_++;
+                    this->skippingLongLine_ = true;
+                    this->end_ = 0;
+                }
+                return true; // wait for more bytes to complete the line
+            }
+            this->tokenize(lastNewline + 1);
+            this->begin_ = lastNewline + 1;
+            return true;
+        }
+
+    public:
+        // Reads from an already open stream such as stdin. The stream is not closed by the reader.
+        explicit TickerStreamReader(std::FILE* file, size_t bufferSize = 64 * 1024)
+            : file_(file), ownsFile_(false), buffer_(bufferSize) {
+            if (bufferSize == 0) {
+                throw std::invalid_argument("Buffer size must be positive");
+            }
+        }
+
+        // Opens filename for reading, "-" means stdin.
+        explicit TickerStreamReader(const std::string& filename, size_t bufferSize = 64 * 1024)
+            : TickerStreamReader(filename == "-" ? stdin : std::fopen(filename.c_str(), "rb"), bufferSize) {
+            if (this->file_ == nullptr) {
+                throw std::runtime_error("Error opening file: " + filename);
+            }
+            this->ownsFile_ = filename != "-";
+        }
+
+        TickerStreamReader(const TickerStreamReader&) = delete;
+        TickerStreamReader& operator=(const TickerStreamReader&) = delete;
+
+        ~TickerStreamReader() {
+            if (this->ownsFile_) {
+                std::fclose(this->file_);
+            }
+        }
+
+        // Fetches the next valid row, reporting bad ones on stderr like the other readers.
+        // The symbol points into the internal buffer and is valid until the following call to next().
+        // Returns false at the end of the input.
+        bool next(TickerView& ticker) {
+            while (this->pendingIndex_ == this->pending_.size()) {
+                if (!this->refill()) {
+                    return false;
+                }
+            }
+            ticker = this->pending_[this->pendingIndex_++];
+            return true;
+        }
+};
+
+// Callback flavour of TickerStreamReader: calls onTicker(const TickerView&) for every row as soon as it has been read.
+template <typename Callback>
+void forEachTickerInStream(std::FILE* file, Callback&& onTicker, size_t bufferSize = 64 * 1024) {
+    TickerStreamReader reader(file, bufferSize);
+    TickerView ticker;
+    while (reader.next(ticker)) {
+        onTicker(ticker);
+    }
+}
+
+
+// --- Benchmarks ---
+
+// Writes a file with the same layout as data/tickers.csv and the requested number of rows.
+void generateSyntheticCsv(const std::string& filename, size_t rows) {
+    const std::vector<std::string> symbols = {"AAPL", "GOOGL", "MSFT", "AMZN", "TSLA", "FB", "NFLX", "NVDA", "BABA", "ORCL", "INTC", "CSCO"};
+
+    std::mt19937 eng(42); // fixed seed for reproducibility
+    std::uniform_int_distribution<size_t> symbolDistr(0, symbols.size() - 1);
+    std::uniform_int_distribution<int> priceCentsDistr(1'000, 500'000);
+    std::uniform_int_distribution<int> volumeDistr(1'000, 2'000'000);
+    std::uniform_int_distribution<int> peTenthsDistr(50, 1'500);
+
+    std::ofstream file(filename, std::ios::binary);
+    file << "ticker,price,volume,peRatio\n";
+    for (size_t i = 0; i < rows; ++i) {
+        int cents = priceCentsDistr(eng);
+        int peTenths = peTenthsDistr(eng);
+        file << symbols[symbolDistr(eng)] << ','
+             << cents / 100 << '.' << (cents % 100 < 10 ? "0" : "") << cents % 100 << ','
+             << volumeDistr(eng) << ','
+             << peTenths / 10 << '.' << peTenths % 10 << '\n';
+    }
+}
+
+// Runs f once and returns the wall clock time it took in seconds.
+template <typename F>
+double timeSeconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void printBenchmarkLine(const std::string& name, double seconds, size_t rows, size_t bytes) {
+    std::cout << name << ": " << seconds * 1000.0 << " ms, "
+              << rows / seconds / 1e6 << " M rows/s, "
+              << bytes / seconds / 1e6 << " MB/s" << std::endl;
+}
+
+// Compares the original readCsv + parseVectorOfTickers path with the memory-mapped one on a synthetic file.
+void runLoaderBenchmark(size_t rows) {
+    const std::string filename = "bench_tickers.csv";
+    generateSyntheticCsv(filename, rows);
+
+    size_t bytes = 0;
+    {
+        MappedFile file(filename);
+        bytes = file.view().size();
+    }
+    std::cout << "Synthetic file: " << rows << " rows, " << bytes / 1e6 << " MB" << std::endl;
+
+    size_t parsed = 0;
+    double seconds = timeSeconds([&] { parsed = parseVectorOfTickers(readCsv(filename)).size(); });
+    printBenchmarkLine("readCsv + parseVectorOfTickers", seconds, parsed, bytes);
+
+    seconds = timeSeconds([&] { parsed = readTickersMapped(filename).size(); });
+    printBenchmarkLine("mmap + parseMappedTickers     ", seconds, parsed, bytes);
+
+    // aggregating straight from the views shows the cost of parsing alone, without building Ticker records
+    long long totalVolume = 0;
+    seconds = timeSeconds([&] {
+        MappedFile file(filename);
+        parsed = 0;
+        forEachTicker(file.view(), [&](const TickerView &ticker) {
+            totalVolume += ticker.volume;
+            parsed++;
+        });
+    });
+    printBenchmarkLine("mmap + forEachTicker (no copy)", seconds, parsed, bytes);
+    std::cout << "(checksum: total volume " << totalVolume << ")" << std::endl;
+
+    std::remove(filename.c_str());
+}
+
+
+// Measures how parseMappedTickersParallel scales with the number of threads.
+void runParallelBenchmark(size_t rows) {
+    const std::string filename = "bench_tickers.csv";
+    generateSyntheticCsv(filename, rows);
+
+    {
+        MappedFile file(filename);
+        std::string_view data = file.view();
+        std::cout << "Synthetic file: " << rows << " rows, " << data.size() / 1e6 << " MB" << std::endl;
+
+        // touch every page once so the first measurement does not pay for reading the disk
+        std::count(data.begin(), data.end(), '\n');
+
+        double singleThreaded = timeSeconds([&] { parseMappedTickers(data); });
+        printBenchmarkLine("parseMappedTickers        ", singleThreaded, rows, data.size());
+
+        size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+            double seconds = timeSeconds([&] { parseMappedTickersParallel(data, threads); });
+            printBenchmarkLine("parallel, " + std::to_string(threads) + " threads" + std::string(threads < 10 ? 6 : 5, ' '), seconds, rows, data.size());
+            std::cout << "    speedup vs single-threaded: " << singleThreaded / seconds << "x" << std::endl;
+        }
+    }
+
+    std::remove(filename.c_str());
+}
+
+
+// Tokenizer throughput on its own: only fields are split, no numbers are converted.
+// The find() based loop is what parseTickerLine and the original parseVectorOfTickers do.
+void runTokenizerBenchmark(size_t rows) {
+    const std::string filename = "bench_tickers.csv";
+    generateSyntheticCsv(filename, rows);
+
+    {
+        MappedFile file(filename);
+        std::string_view data = file.view();
+        std::cout << "Synthetic file: " << rows << " rows, " << data.size() / 1e6 << " MB" << std::endl;
+        std::count(data.begin(), data.end(), '\n'); // fault every page in before timing
+
+        auto report = [&](const std::string& name, double seconds, size_t fields) {
+            std::cout << name << ": " << data.size() / seconds / 1e9 << " GB/s (" << fields << " fields)" << std::endl;
+        };
+
+        const int repeats = 5;
+        size_t fields = 0;
+        double seconds = timeSeconds([&] {
+            for (int r = 0; r < repeats; ++r) {
+                fields = 0;
+                size_t pos = 0;
+                while (pos < data.size()) {
+                    size_t newlinePos = std::min(data.find('\n', pos), data.size());
+                    std::string_view line = data.substr(pos, newlinePos - pos);
+                    for (size_t commaPos = line.find(','); commaPos != std::string_view::npos; commaPos = line.find(',')) {
+                        fields++;
+                        line.remove_prefix(commaPos + 1);
+                    }
+                    fields++;
+                    pos = newlinePos + 1;
+                }
+            }
+        }) / repeats;
+        report("find() loop", seconds, fields);
+
+        for (const DelimiterKernelInfo &info : availableDelimiterKernels()) {
+            seconds = timeSeconds([&] {
+                for (int r = 0; r < repeats; ++r) {
+                    fields = 0;
+                    tokenizeLines(data, info.kernel, [&fields](const std::string_view*, size_t fieldCount, size_t) {
+                        fields += fieldCount;
+                    });
+                }
+            }) / repeats;
+            report(std::string("bitmask tokenizer, ") + info.name + " kernel", seconds, fields);
+        }
+    }
+
+    std::remove(filename.c_str());
+}
+
+// Same aggregates over std::vector<Ticker> and over TickerTable with every available kernel set.
+void runTableBenchmark(size_t rows) {
+    const std::string filename = "bench_tickers.csv";
+    generateSyntheticCsv(filename, rows);
+
+    std::vector<Ticker> tickers;
+    TickerTable table;
+    {
+        MappedFile file(filename);
+        tickers = parseMappedTickers(file.view());
+        table = TickerTable::fromCsv(file.view());
+    }
+    std::remove(filename.c_str());
+    std::cout << "Rows: " << table.size() << ", sizeof(Ticker): " << sizeof(Ticker) << " bytes" << std::endl;
+
+    // runs compute a few times and prints the time per row together with its result, so the work cannot be optimized away
+    auto measure = [&](const std::string& name, auto&& compute) {
+        const int repeats = 20;
+        double result = 0.0;
+        double seconds = timeSeconds([&] {
+            for (int r = 0; r < repeats; ++r) result = compute();
+        });
+        std::cout << "  " << name << ": " << seconds / repeats * 1e9 / tickers.size() << " ns/row (result " << result << ")" << std::endl;
+    };
+
+    std::cout << "std::vector<Ticker>:" << std::endl;
+    measure("sum price", [&] {
+        double sum = 0.0;
+        for (const Ticker &ticker : tickers) sum += ticker.price;
+        return sum;
+    });
+    measure("min/max  ", [&] {
+        double min = std::numeric_limits<double>::infinity(), max = -min;
+        for (const Ticker &ticker : tickers) {
+            min = std::min(min, ticker.price);
+            max = std::max(max, ticker.price);
+        }
+        return max - min;
+    });
+    measure("vwap     ", [&] {
+        double notional = 0.0;
+        long long volume = 0;
+        for (const Ticker &ticker : tickers) {
+            notional += ticker.price * ticker.volume;
+            volume += ticker.volume;
+        }
+        return notional / volume;
+    });
+    measure("pe < 20  ", [&] {
+        std::vector<uint32_t> matches;
+        for (size_t i = 0; i < tickers.size(); ++i) {
+            if (tickers[i].peRatio < 20.0f) matches.push_back(static_cast<uint32_t>(i));
+        }
+        return static_cast<double>(matches.size());
+    });
+
+    for (const ColumnKernels &kernels : availableColumnKernels()) {
+        std::cout << "TickerTable, " << kernels.name << " kernels:" << std::endl;
+        TickerColumns columns = table.columns();
+        measure("sum price", [&] { return columns.sumPrice(kernels); });
+        measure("min/max  ", [&] { return columns.maxPrice(kernels) - columns.minPrice(kernels); });
+        measure("vwap     ", [&] { return columns.vwap(kernels); });
+        measure("pe < 20  ", [&] { return static_cast<double>(columns.rowsWithPeRatioBelow(20.0f, kernels).size()); });
+    }
+}
+
+// Asks the OS to forget the cached pages of a file, so the next read really comes from disk.
+// Only a hint and only available on POSIX systems, elsewhere "cold" numbers are really warm ones.
+void evictFromPageCache(const std::string& filename) {
+#if defined(POSIX_FADV_DONTNEED)
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#else
+    (void)filename;
+#endif
+}
+
+// Time from "file on disk" to "first aggregate computed" for the CSV and the snapshot.
+void runStartupBenchmark(size_t rows) {
+    const std::string csvFilename = "bench_tickers.csv";
+    const std::string snapshotFilename = "bench_tickers.snap";
+    generateSyntheticCsv(csvFilename, rows);
+    {
+        MappedFile file(csvFilename);
+        writeTickerSnapshot(TickerTable::fromCsv(file.view()), snapshotFilename);
+    }
+    std::cout << "Rows: " << rows << std::endl;
+
+    double vwap = 0.0;
+    for (bool cold : {true, false}) {
+        std::cout << (cold ? "Cold start (page cache evicted):" : "Warm start (file cached):") << std::endl;
+
+        if (cold) evictFromPageCache(csvFilename);
+        double seconds = timeSeconds([&] {
+            MappedFile file(csvFilename);
+            vwap = TickerTable::fromCsv(file.view()).columns().vwap();
+        });
+        std::cout << "  CSV -> TickerTable               : " << seconds * 1000.0 << " ms (vwap " << vwap << ")" << std::endl;
+
+        if (cold) evictFromPageCache(snapshotFilename);
+        seconds = timeSeconds([&] {
+            vwap = TickerSnapshot(snapshotFilename).columns().vwap();
+        });
+        std::cout << "  snapshot, checksum verified      : " << seconds * 1000.0 << " ms (vwap " << vwap << ")" << std::endl;
+
+        if (cold) evictFromPageCache(snapshotFilename);
+        seconds = timeSeconds([&] {
+            vwap = TickerSnapshot(snapshotFilename, false).columns().vwap();
+        });
+        std::cout << "  snapshot, no checksum            : " << seconds * 1000.0 << " ms (vwap " << vwap << ")" << std::endl;
+
+        if (cold) evictFromPageCache(snapshotFilename);
+        size_t symbolCount = 0;
+        seconds = timeSeconds([&] {
+            symbolCount = TickerSnapshot(snapshotFilename, false).symbolCount();
+        });
+        std::cout << "  snapshot open only, no checksum  : " << seconds * 1000.0 << " ms (" << symbolCount << " symbols)" << std::endl;
+    }
+
+    std::remove(csvFilename.c_str());
+    std::remove(snapshotFilename.c_str());
+}
+
+// Peak resident memory of this process so far, in MB (0 where the platform does not report it).
+double peakMemoryMb() {
+#if defined(_WIN32)
+    return 0.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1e6; // bytes on macOS
+#else
+    return usage.ru_maxrss / 1e3; // kilobytes on Linux
+#endif
+#endif
+}
+
+// Streams a synthetic file through a small buffer and shows that peak memory does not grow with the file size.
+// Runs before anything else allocates, because the peak can only go up.
+void runStreamBenchmark(size_t rows) {
+    const std::string filename = "bench_tickers.csv";
+    generateSyntheticCsv(filename, rows);
+    double memoryBefore = peakMemoryMb();
+
+    size_t parsed = 0;
+    long long totalVolume = 0;
+    size_t bytes = 0;
+    double seconds = timeSeconds([&] {
+        TickerStreamReader reader(filename, 64 * 1024);
+        TickerView ticker;
+        while (reader.next(ticker)) {
+            totalVolume += ticker.volume;
+            parsed++;
+        }
+    });
+    {
+        MappedFile file(filename);
+        bytes = file.view().size();
+    }
+    std::cout << "Synthetic file: " << rows << " rows, " << bytes / 1e6 << " MB" << std::endl;
+    printBenchmarkLine("stream, 64 KiB buffer", seconds, parsed, bytes);
+    std::cout << "  peak memory before: " << memoryBefore << " MB, after streaming: " << peakMemoryMb() << " MB"
+              << " (checksum: total volume " << totalVolume << ")" << std::endl;
+
+    seconds = timeSeconds([&] { parsed = readTickersMapped(filename).size(); });
+    printBenchmarkLine("mmap into std::vector<Ticker>", seconds, parsed, bytes);
+    std::cout << "  peak memory after loading everything: " << peakMemoryMb() << " MB" << std::endl;
+
+    std::remove(filename.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    // "bench [rows]" compares the loaders on a synthetic file instead of printing the tickers
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        runLoaderBenchmark(argc > 2 ? std::stoul(argv[2]) : 1'000'000);
+        return 0;
+    }
+    // "bench-tokenizer [rows]" reports the GB/s of each delimiter scanning kernel
+    if (argc > 1 && std::string(argv[1]) == "bench-tokenizer") {
+        runTokenizerBenchmark(argc > 2 ? std::stoul(argv[2]) : 1'000'000);
+        return 0;
+    }
+    // "bench-table [rows]" compares column aggregates against looping over std::vector<Ticker>
+    if (argc > 1 && std::string(argv[1]) == "bench-table") {
+        runTableBenchmark(argc > 2 ? std::stoul(argv[2]) : 5'000'000);
+        return 0;
+    }
+    // "bench-startup [rows]" measures cold and warm start from CSV versus from a binary snapshot
+    if (argc > 1 && std::string(argv[1]) == "bench-startup") {
+        runStartupBenchmark(argc > 2 ? std::stoul(argv[2]) : 5'000'000);
+        return 0;
+    }
+    // "convert <input.csv> <output.snap>" writes a binary snapshot of a ticker CSV
+    if (argc > 1 && std::string(argv[1]) == "convert") {
+        if (argc < 4) {
+            std::cerr << "Usage: " << argv[0] << " convert <input.csv> <output.snap>" << std::endl;
+            return 1;
+        }
+        try {
+            MappedFile file(argv[2]);
+            TickerTable table = TickerTable::fromCsv(file.view());
+            writeTickerSnapshot(table, argv[3]);
+            std::cout << "Wrote " << table.size() << " rows to " << argv[3] << std::endl;
+        } catch (std::exception &e) {
+            std::cerr << "Exception occurred: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    // "bench-stream [rows]" shows streaming throughput and that its memory stays flat
+    if (argc > 1 && std::string(argv[1]) == "bench-stream") {
+        runStreamBenchmark(argc > 2 ? std::stoul(argv[2]) : 5'000'000);
+        return 0;
+    }
+    // "bench-parallel [rows]" shows how the chunked parser scales with thread count
+    if (argc > 1 && std::string(argv[1]) == "bench-parallel") {
+        runParallelBenchmark(argc > 2 ? std::stoul(argv[2]) : 10'000'000);
+        return 0;
+    }
+
+    std::string filename = argc > 1 ? argv[1] : "data/tickers.csv";
+
+    // snapshots written by "convert" are printed straight from the mapping
+    if (filename.size() > 5 && filename.compare(filename.size() - 5, 5, ".snap") == 0) {
+        try {
+            TickerSnapshot snapshot(filename);
+            for (size_t i = 0; i < snapshot.size(); ++i) {
+                TickerView ticker = snapshot.row(i);
+                std::cout << "Symbol: " << ticker.symbol << ", Price: " << ticker.price
+                          << ", Volume: " << ticker.volume << ", P/E Ratio: " << ticker.peRatio << std::endl;
+            }
+        } catch (std::exception &e) {
+            std::cerr << "Exception occurred: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // "-" reads from stdin, e.g. "cat data/tickers.csv | readingCsv -", and prints rows as they arrive
+    if (filename == "-") {
+        try {
+            forEachTickerInStream(stdin, [](const TickerView &ticker) {
+                std::cout << "Symbol: " << ticker.symbol << ", Price: " << ticker.price
+                          << ", Volume: " << ticker.volume << ", P/E Ratio: " << ticker.peRatio << std::endl;
+            });
+        } catch (std::exception &e) {
+            std::cerr << "Exception occurred: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    std::vector<Ticker> tickers = readTickersMapped(filename);
     for (const Ticker &ticker : tickers) {
-        std::cout << "Symbol: " << ticker.symbol << ", Price: " << ticker.price
+        std::cout << "Symbol: " << globalSymbols().name(ticker.symbol) << ", Price: " << ticker.price
                   << ", Volume: " << ticker.volume << ", P/E Ratio: " << ticker.peRatio << std::endl;
     }
     return 0;
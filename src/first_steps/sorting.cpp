@@ -1,14 +1,19 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <string>
+#include <random>
+#include <chrono>
+
+#include "symbol_table.hpp"
 
 struct Stock {
-    std::string ticker;
+    SymbolId symbol;
     double price;
     int peRatio;
 };
 
-double compareByPrice(const Stock &a, const Stock &b) {
+bool compareByPrice(const Stock &a, const Stock &b) {
     return a.price < b.price;
 }
 
@@ -19,19 +24,53 @@ std::vector<Stock> sortByPrice(std::vector<Stock> &stocks) {
 
 void printVector(const std::vector<Stock> &stocks) {
     for (const Stock &stock : stocks) {
-        std::cout << "Ticker: " << stock.ticker 
+        std::cout << "Ticker: " << globalSymbols().name(stock.symbol) 
                   << ", Price: " << stock.price 
                   << ", P/E Ratio: " << stock.peRatio << std::endl;
     }
 }
 
-int main() {
+// Sorting moves every element around many times, so the size of Stock matters:
+// with a std::string ticker it was 48 bytes, with a SymbolId it is 24.
+void runSortBenchmark(size_t count) {
+    std::vector<SymbolId> symbols;
+    for (int i = 0; i < 5'000; ++i) {
+        symbols.push_back(globalSymbols().intern("SYM" + std::to_string(i)));
+    }
+
+    std::mt19937 eng(42); // fixed seed for reproducibility
+    std::uniform_int_distribution<size_t> symbolDistr(0, symbols.size() - 1);
+    std::uniform_real_distribution<double> priceDistr(1.0, 5'000.0);
+    std::uniform_int_distribution<int> peDistr(5, 150);
+
+    std::vector<Stock> stocks;
+    stocks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        stocks.push_back({symbols[symbolDistr(eng)], priceDistr(eng), peDistr(eng)});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::sort(stocks.begin(), stocks.end(), compareByPrice);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "sizeof(Stock): " << sizeof(Stock) << " bytes" << std::endl;
+    std::cout << "Sorted " << count << " stocks by price in " << seconds * 1000.0 << " ms, "
+              << count / seconds / 1e6 << " M stocks/s" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    // "bench [count]" times sorting a large random portfolio instead of the demo
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        runSortBenchmark(argc > 2 ? std::stoul(argv[2]) : 5'000'000);
+        return 0;
+    }
+
     std::vector<Stock> portfolio = {
-        {"AAPL", 150.0, 28},
-        {"MSFT", 250.0, 35},
-        {"GOOGL", 2800.0, 30},
-        {"AMZN", 3400.0, 60},
-        {"TSLA", 700.0, 100}
+        {globalSymbols().intern("AAPL"), 150.0, 28},
+        {globalSymbols().intern("MSFT"), 250.0, 35},
+        {globalSymbols().intern("GOOGL"), 2800.0, 30},
+        {globalSymbols().intern("AMZN"), 3400.0, 60},
+        {globalSymbols().intern("TSLA"), 700.0, 100}
     };
 
     std::cout << "Portfolio before sorting:" << std::endl;
@@ -43,4 +82,4 @@ int main() {
     printVector(portfolio);
 
     return 0;
-}
\ No newline at end of file
+}
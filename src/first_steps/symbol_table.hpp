@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Shared by every program that handles tickers (portfolio.cpp, sorting.cpp, readingCsv.cpp).
+// Tickers are turned into small integer ids once, when data comes in, and the structs carry the id from then on:
+// comparing or hashing an id is one integer instruction, comparing strings is a loop over characters,
+// and copying an id never allocates. The name is only looked up again for printing.
+
+// Dense 32-bit number standing in for a ticker string: the first distinct ticker gets 0, the next 1, ...
+using SymbolId = uint32_t;
+
+// Gives every distinct ticker string a SymbolId the first time it is seen.
+// Safe to use from several threads: lookups of known tickers share a read lock, only new tickers take the write lock.
+// std::deque never moves its elements when it grows, so the string_view keys of ids_ and the views
+// returned by name() stay valid for the lifetime of the table.
+class SymbolTable {
+    private:
+        std::deque<std::string> names_;
+        std::unordered_map<std::string_view, SymbolId> ids_;
+        mutable std::shared_mutex mutex_;
+
+    public:
+        SymbolId intern(std::string_view ticker) {
+            {
+                std::shared_lock<std::shared_mutex> lock(this->mutex_);
+                auto it = this->ids_.find(ticker);
+                if (it != this->ids_.end()) {
+                    return it->second;
+                }
+            }
+            std::unique_lock<std::shared_mutex> lock(this->mutex_);
+            // another thread may have added it between the two locks
+            auto it = this->ids_.find(ticker);
+            if (it != this->ids_.end()) {
+                return it->second;
+            }
+            SymbolId id = static_cast<SymbolId>(this->names_.size());
+            this->names_.emplace_back(ticker);
+            this->ids_.emplace(this->names_.back(), id);
+            return id;
+        }
+
+        // Reverse lookup, for printing.
+        std::string_view name(SymbolId id) const {
+            std::shared_lock<std::shared_mutex> lock(this->mutex_);
+            return this->names_.at(id);
+        }
+
+        size_t size() const {
+            std::shared_lock<std::shared_mutex> lock(this->mutex_);
+            return this->names_.size();
+        }
+};
+
+// The one table the whole program shares, so an id means the same ticker everywhere.
+inline SymbolTable& globalSymbols() {
+    static SymbolTable table;
+    return table;
+}
+
+// Per-thread front for globalSymbols(). Remembers the ids this thread already looked up, so a hot loop that interns
+// the same few thousand tickers millions of times (like the parallel CSV parser) does not hit the shared lock every time.
+class SymbolCache {
+    private:
+        SymbolTable* table_; // a pointer rather than a reference keeps the cache assignable
+        std::unordered_map<std::string_view, SymbolId> ids_; // keys point into table_, not into the caller's buffer
+
+    public:
+        explicit SymbolCache(SymbolTable& table = globalSymbols()) : table_(&table) {}
+
+        SymbolId intern(std::string_view ticker) {
+            auto it = this->ids_.find(ticker);
+            if (it != this->ids_.end()) {
+                return it->second;
+            }
+            SymbolId id = this->table_->intern(ticker);
+            this->ids_.emplace(this->table_->name(id), id);
+            return id;
+        }
+};
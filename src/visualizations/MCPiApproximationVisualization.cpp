@@ -3,10 +3,14 @@
 #include <random>
 #include <vector>
 #include <array>
-#include <limits>
+#include <cstdint>
 #include <algorithm>
+#include <chrono>
+#include <string>
 #include <SFML/Graphics.hpp>
 
+#include "../first_steps/monte_carlo_integrator.hpp"
+
 /*
 In this project we visualize the Monte Carlo method for approximating Pi.
 We generate random points in a unit square and determine how many fall within a quarter circle inscribed within that square.
@@ -15,84 +19,239 @@ The visualization animates the point generation process and displays real-time s
 This implementation uses SFML for rendering
 */
 
-struct Pt {
-    std::array<double, 2> coords;
-    bool inside;
-};
-
 // Class to approximate Pi using Monte Carlo method
-// For this file we mainly use it to generate points for the animation
+// For this file we mainly use it to generate points for the animation.
+// Points are generated lazily: the animation asks for the first n points with generate(n) as it shows them,
+// so the window opens immediately and memory grows with the points actually on screen, not with samples.
+// A few thousand new points per frame take microseconds, so there is no need for a background thread.
+// Storage is structure of arrays: x and y as floats (plenty for pixel positions) and one bit per point for inside,
+// about 8 bytes per point instead of 24 for a struct of two doubles and a bool.
+// The inside bit is computed from the full double point, before it is rounded to float.
 class PiApproximation {
     private:
 
         int samples_;
-        std::vector<Pt> points_;
+        Xoshiro256Plus generator_;
+        std::vector<float> xs_;
+        std::vector<float> ys_;
+        std::vector<bool> inside_;
+
+        static uint64_t randomSeed() {
+            std::random_device rd;
+            return (static_cast<uint64_t>(rd()) << 32) | rd();
+        }
+
+        // same quarter circle test as pi_approximation.cpp and its integrator
+        bool inside(const std::array<double, 2>& point) {
+            return QuarterCircle::inside(point[0], point[1]);
+        }
+
+    public:
 
-        static double random_double(double lowerBound, double upperBound) {
-            // Validate input bounds
-            if (lowerBound > upperBound) {
-                throw std::invalid_argument("lowerBound must be less than or equal to upperBound");
+        // Constructor, generates nothing yet. A fixed seed gives the same points every run (the benchmark uses one).
+        PiApproximation(int samples, uint64_t seed = randomSeed()) : samples_(samples), generator_(seed) {
+            if (samples <= 0) {
+                throw std::invalid_argument("Number of samples must be positive");
             }
-            if (lowerBound == upperBound) {
-                return lowerBound; // closed interval degenerates to a single value
+        }
+
+        // Destructor
+        ~PiApproximation() = default;
+
+        // -- APIs --
+
+        // Makes sure the first count points exist (at most samples), generating only the missing ones.
+        // Returns how many points there are now.
+        size_t generate(size_t count) {
+            count = std::min(count, static_cast<size_t>(this->samples_));
+            while (this->xs_.size() < count) {
+                std::array<double, 2> point = { unitInterval(this->generator_.next()), unitInterval(this->generator_.next()) };
+                this->xs_.push_back(static_cast<float>(point[0]));
+                this->ys_.push_back(static_cast<float>(point[1]));
+                this->inside_.push_back(inside(point));
             }
-            
-            static std::random_device rd;
-            static thread_local std::mt19937 eng(rd());
+            return this->xs_.size();
+        }
 
-            // normally real distribution is [a, b), thats why we use nextafter to include upperBound
-            std::uniform_real_distribution<double> distr(lowerBound, std::nextafter(upperBound, std::numeric_limits<double>::infinity()));
+        size_t size() const {
+            return this->xs_.size();
+        }
 
-            return distr(eng);
+        int getSamples() const {
+            return this->samples_;
         }
 
-        double calculateDistanceFromOrigin(const std::array<double, 2>& point) {
-            // hypot is more numerically stable than manual sqrt(x*x + y*y)
-            return std::hypot(point[0], point[1]);
+        float x(size_t i) const {
+            return this->xs_[i];
         }
 
-        bool inside(const std::array<double, 2>& point) {
-            return calculateDistanceFromOrigin(point) <= 1.0;
+        float y(size_t i) const {
+            return this->ys_[i];
         }
 
-        void generatePoints() {
-            int lowerBound = 0;
-            int upperBound = 1;
+        bool isInside(size_t i) const {
+            return this->inside_[i];
+        }
+
+        // Forgets the current points and starts a new random sequence.
+        // The memory is released too, the new points are generated lazily like the first ones.
+        void resetPoints() {
+            this->generator_ = Xoshiro256Plus(randomSeed());
+            std::vector<float>().swap(this->xs_);
+            std::vector<float>().swap(this->ys_);
+            std::vector<bool>().swap(this->inside_);
+        }
+};
 
-            for (int i = 0; i < this->samples_; i++) {
-                Pt point;
-                point.coords = { random_double(lowerBound, upperBound), random_double(lowerBound, upperBound) };
-                point.inside = inside(point.coords);
-                this->points_.push_back(point);
+// The points on screen, kept between frames.
+// Every point is one vertex (a 1 pixel sf::PrimitiveType::Points), appended once when it first becomes visible and
+// drawn with the rest in a single draw call, instead of building and drawing an sf::CircleShape per point every frame.
+// With vertex buffer support the vertices live on the GPU: each frame uploads only the new ones at the end of the
+// buffer, and the buffer doubles (copying GPU side) when it is full. Without it they go into an sf::VertexArray.
+// Also counts the inside points as they are added, so the statistics do not need a loop over all points either.
+class PointCloud : public sf::Drawable {
+    private:
+
+        sf::Vector2f origin_;
+        sf::Vector2f unitX_; // window offset of x = 1
+        sf::Vector2f unitY_; // window offset of y = 1
+        bool useBuffer_;
+        sf::VertexBuffer buffer_;
+        sf::VertexArray array_;
+        std::vector<sf::Vertex> pending_; // this frame's new vertices, staged for one upload
+        size_t count_ = 0;
+        size_t inside_ = 0;
+
+        void upload() {
+            if (this->pending_.empty()) {
+                return;
+            }
+            if (this->useBuffer_) {
+                size_t needed = this->count_ + this->pending_.size();
+                if (needed > this->buffer_.getVertexCount()) {
+                    size_t capacity = std::max<size_t>(needed, 2 * this->buffer_.getVertexCount());
+                    sf::VertexBuffer bigger(sf::PrimitiveType::Points, sf::VertexBuffer::Usage::Stream);
+                    if (!bigger.create(capacity) || (this->count_ > 0 && !bigger.update(this->buffer_))) {
+                        throw std::runtime_error("Could not grow the point vertex buffer");
+                    }
+                    this->buffer_.swap(bigger);
+                }
+                if (!this->buffer_.update(this->pending_.data(), this->pending_.size(), static_cast<unsigned>(this->count_))) {
+                    throw std::runtime_error("Could not upload points to the vertex buffer");
+                }
+            } else {
+                for (const sf::Vertex& vertex : this->pending_) {
+                    this->array_.append(vertex);
+                }
+            }
+            this->count_ += this->pending_.size();
+            this->pending_.clear();
+        }
+
+        void draw(sf::RenderTarget& target, sf::RenderStates states) const override {
+            if (this->count_ == 0) {
+                return;
+            }
+            if (this->useBuffer_) {
+                target.draw(this->buffer_, 0, this->count_, states);
+            } else {
+                target.draw(this->array_, states);
             }
         }
 
     public:
 
-        // Constructor
-        PiApproximation(int samples) : samples_(samples) {
-            if (samples <= 0) {
-                throw std::invalid_argument("Number of samples must be positive");
+        PointCloud(sf::Vector2f origin, sf::Vector2f unitX, sf::Vector2f unitY)
+            : origin_(origin), unitX_(unitX), unitY_(unitY), useBuffer_(sf::VertexBuffer::isAvailable()),
+              buffer_(sf::PrimitiveType::Points, sf::VertexBuffer::Usage::Stream), array_(sf::PrimitiveType::Points) {}
+
+        // Appends the points of source from size() up to count (both generated already), then uploads them in one go.
+        void appendUpTo(const PiApproximation& source, size_t count) {
+            count = std::min(count, source.size());
+            for (size_t i = this->count_; i < count; ++i) {
+                bool inside = source.isInside(i);
+                this->inside_ += inside;
+                sf::Vector2f position = this->origin_ + source.x(i) * this->unitX_ + source.y(i) * this->unitY_;
+                this->pending_.push_back(sf::Vertex{position, inside ? sf::Color::Blue : sf::Color::Red});
             }
-            generatePoints();
+            this->upload();
         }
 
-        // Destructor
-        ~PiApproximation() = default;
+        // Forgets the points, keeps the buffer for the next ones.
+        void clear() {
+            this->count_ = 0;
+            this->inside_ = 0;
+            this->array_.clear();
+        }
 
-        // -- APIs --
-        std::vector<Pt>& getPoints() {
-            return this->points_;
+        size_t size() const {
+            return this->count_;
         }
 
-        void resetPoints() {
-            this->points_.clear();
-            generatePoints();
+        size_t insideCount() const {
+            return this->inside_;
+        }
+
+        bool usesVertexBuffer() const {
+            return this->useBuffer_;
         }
 };
 
+// Renders into an offscreen sf::RenderTexture, no window needed: appends points in frames of pointsPerFrame
+// and prints the frame time (clear, one draw, display) as the cloud grows to totalPoints.
+// With a point per shape the frame time grew with the points; with the cloud it should stay flat.
+int runRenderBenchmark(size_t totalPoints, size_t pointsPerFrame) {
+    sf::RenderTexture texture;
+    if (!texture.resize({1000u, 1000u})) {
+        std::cerr << "Error creating render texture" << std::endl;
+        return 1;
+    }
+    PiApproximation piApprox(static_cast<int>(totalPoints), 42);
+    PointCloud cloud(sf::Vector2f(250.0f, 750.0f), sf::Vector2f(500.0f, 0.0f), sf::Vector2f(0.0f, -500.0f));
+    std::cout << (cloud.usesVertexBuffer() ? "vertex buffer" : "vertex array (no vertex buffer support)") << std::endl;
+
+    size_t nextReport = 1;
+    while (cloud.size() < totalPoints) {
+        size_t target = std::min(cloud.size() + pointsPerFrame, totalPoints);
+        auto start = std::chrono::steady_clock::now();
+        piApprox.generate(target);
+        cloud.appendUpTo(piApprox, target);
+        texture.clear(sf::Color::White);
+        texture.draw(cloud);
+        texture.display();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (cloud.size() >= nextReport || cloud.size() == totalPoints) {
+            std::cout << cloud.size() << " points: " << seconds * 1e3 << " ms per frame, pi ~ "
+                      << 4.0 * cloud.insideCount() / static_cast<double>(cloud.size()) << std::endl;
+            nextReport = cloud.size() * 10;
+        }
+    }
+
+    // A pixel is 1/250000 of the square, so with 10M points it gets 40 on average and stays white with probability
+    // e^-40; with 1M it would be e^-4, about 2%. The seed is fixed, so the result is the same on every run anyway.
+    // Pixels inside the quarter circle, in square coordinates: (0.25, 0.25), (0.5, 0.5) and (0.1, 0.6).
+    if (totalPoints >= 10000000) {
+        sf::Image image = texture.getTexture().copyToImage();
+        const sf::Vector2u insidePixels[] = {{375u, 625u}, {500u, 500u}, {300u, 450u}};
+        bool allBlue = true;
+        for (sf::Vector2u pixel : insidePixels) {
+            allBlue = allBlue && image.getPixel(pixel) == sf::Color::Blue;
+        }
+        std::cout << "pixels inside the quarter circle are " << (allBlue ? "blue, as expected" : "NOT all blue") << std::endl;
+        return allBlue ? 0 : 1;
+    }
+    return 0;
+}
+
 
-int main() {
+int main(int argc, char* argv[]) {
+
+    // "bench [points] [pointsPerFrame]" renders offscreen and reports frame times, no window
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        size_t totalPoints = argc > 2 ? std::stoull(argv[2]) : 10000000;
+        size_t pointsPerFrame = argc > 3 ? std::stoull(argv[3]) : 100000;
+        return runRenderBenchmark(totalPoints, pointsPerFrame);
+    }
 
     // -- Setup simulation parameters --
     const int nSamples = 10000000;
@@ -100,9 +259,8 @@ int main() {
     const float rectangleSize = 500.0f;
     const float pointsPerSecond = 1000.0f; // Speed of animation
 
-    // -- Generate points --
+    // -- Point source, points are generated as the animation reaches them --
     PiApproximation piApprox(nSamples);
-    std::vector<Pt>& points = piApprox.getPoints();
 
     // -- Setup SFML -- 
     // Create a window (SFML 3.x uses Vector2u for size)
@@ -121,6 +279,9 @@ int main() {
     sf::Vector2f Vx = sf::Vector2f(rectangleSize / (pointsPerPixel * 100), 0.0f); // vector along x-axis
     sf::Vector2f Vy = sf::Vector2f(0.0f, - rectangleSize / (pointsPerPixel * 100)); // vector along y-axis
 
+    // Points shown so far, appended as they appear and drawn in one call
+    PointCloud cloud(Origin, Vx * static_cast<float>(pointsPerPixel * 100), Vy * static_cast<float>(pointsPerPixel * 100));
+
     // Animation control
     size_t currentPointIndex = 0;
     sf::Clock clock;
@@ -171,6 +332,7 @@ int main() {
                     // Check if reset button was clicked
                     if (resetButton.getGlobalBounds().contains(mousePos)) {
                         currentPointIndex = 0;
+                        cloud.clear();
                         isPaused = false;
                         clock.restart();
                     }
@@ -178,9 +340,9 @@ int main() {
                     // Check if new points button was clicked
                     if (newPointsButton.getGlobalBounds().contains(mousePos)) {
                         currentPointIndex = 0;
+                        cloud.clear();
                         isPaused = false;
                         piApprox.resetPoints();
-                        points = piApprox.getPoints();
                         clock.restart();
                     }
                 }
@@ -199,14 +361,15 @@ int main() {
                 if (keyEvent && keyEvent->code == sf::Keyboard::Key::R) {
                     isPaused = false;
                     currentPointIndex = 0;
+                    cloud.clear();
                     clock.restart();
                 }
 
                 if (keyEvent && keyEvent->code == sf::Keyboard::Key::G) {
                     currentPointIndex = 0;
+                    cloud.clear();
                     isPaused = false;
                     piApprox.resetPoints();
-                    points = piApprox.getPoints();
                     clock.restart();
                 }
                 
@@ -234,11 +397,12 @@ int main() {
         // Update animation - add more points based on elapsed time (only if not paused)
         if (!isPaused) {
             float elapsed = clock.restart().asSeconds();
-            int pointsToAdd = static_cast<int>(elapsed * pointsPerSecond) < points.size() ? static_cast<int>(elapsed * pointsPerSecond) : points.size();
-            currentPointIndex = std::min(currentPointIndex + pointsToAdd, points.size());
+            size_t pointsToAdd = std::min(static_cast<size_t>(elapsed * pointsPerSecond), static_cast<size_t>(nSamples));
+            currentPointIndex = std::min(currentPointIndex + pointsToAdd, static_cast<size_t>(nSamples));
         } else {
             clock.restart(); // Keep restarting clock while paused to avoid accumulation
         }
+        piApprox.generate(currentPointIndex); // only the points that became visible this frame are new
 
         // draw square outline
         sf::RectangleShape square(sf::Vector2f(rectangleSize, rectangleSize));
@@ -259,32 +423,13 @@ int main() {
         }
         window.draw(arc);
 
-        // statistics for currently displayed points
-        int pointsInside = 0;
-        int pointsOutside = 0;
-        
-        // Draw all points up to currentPointIndex
-        for (int i = 0; i < currentPointIndex; ++i) {
-            const Pt& pt = points[i];
-
-            sf::CircleShape pointShape(1); // radius of 1 pixel
+        // Add the points that became visible this frame and draw them all with one call
+        cloud.appendUpTo(piApprox, currentPointIndex);
+        window.draw(cloud);
 
-            // Set color based on whether point is inside the circle
-            // add statistics counting in one loop rather than separate
-            if (pt.inside) {
-                pointShape.setFillColor(sf::Color::Blue);
-                pointsInside++;
-            } else {
-                pointShape.setFillColor(sf::Color::Red);
-                pointsOutside++;
-            }
-            
-            // Calculate position in window coordinates
-            sf::Vector2f position = Origin + static_cast<sf::Vector2f>((static_cast<float>(pt.coords[0]) * pointsPerPixel * 100) * Vx + (static_cast<float>(pt.coords[1]) * pointsPerPixel * 100) * Vy);
-            pointShape.setPosition(position);
-            
-            window.draw(pointShape);
-        }
+        // statistics for currently displayed points, counted by the cloud as points were added
+        size_t pointsInside = cloud.insideCount();
+        size_t pointsOutside = cloud.size() - pointsInside;
 
         // Calculate current pi estimate
         double currentPiEstimate = 0.0;